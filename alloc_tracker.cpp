@@ -0,0 +1,141 @@
+#include <bits/stdc++.h>
+#ifdef _WIN32
+#include <malloc.h>
+#endif
+#include "alloc_tracker.h"
+using namespace std;
+
+// Constant-initialized, so allocations made before main() are safe to count
+AllocationTracker g_alloc_tracker;
+thread_local AllocationStage AllocationTracker::current_stage = AllocationStage::NONE;
+
+// Report row names, indexed by AllocationStage
+static constexpr const char* ALLOCATION_STAGE_NAMES[] = {
+    "untracked", "place order", "prepare", "cook", "complete", "deliver", "refund", "status line"
+};
+
+string allocationStageToString(AllocationStage stage) {
+    return ALLOCATION_STAGE_NAMES[static_cast<int>(stage)];
+}
+
+// AllocationTracker implementation
+AllocationCounts AllocationTracker::getCounts(AllocationStage stage) const {
+    const StageCounters& counters = stages[static_cast<int>(stage)];
+    return {counters.passes.load(memory_order_relaxed), counters.allocations.load(memory_order_relaxed),
+            counters.bytes.load(memory_order_relaxed)};
+}
+
+void AllocationTracker::printReport(ostream& out) const {
+    out << "\n" << string(50, '=') << endl;
+    out << "HEAP ALLOCATIONS BY ORDER STAGE" << endl;
+    out << string(50, '=') << endl;
+    out << left << setfill(' ') << setw(14) << "Stage" << right << setw(8) << "Passes" << setw(10) << "Allocs"
+        << setw(12) << "Bytes" << setw(12) << "Allocs/pass" << setw(12) << "Bytes/pass" << endl;
+    out << fixed << setprecision(1);
+    for (int i = 1; i < ALLOCATION_STAGE_COUNT; ++i) {
+        AllocationCounts counts = getCounts(static_cast<AllocationStage>(i));
+        if (counts.passes == 0) {
+            continue;
+        }
+        out << left << setw(14) << ALLOCATION_STAGE_NAMES[i] << right << setw(8) << counts.passes << setw(10)
+            << counts.allocations << setw(12) << counts.bytes << setw(12)
+            << static_cast<double>(counts.allocations) / counts.passes << setw(12)
+            << static_cast<double>(counts.bytes) / counts.passes << endl;
+    }
+    out << defaultfloat << setprecision(6);
+    out << "Status lines are counted on their own, not in the stage that printed them." << endl;
+}
+
+// Replacement global allocation functions. Everything goes through malloc /
+// free (or their aligned counterparts), following the standard new-handler
+// protocol when memory runs out.
+static void* trackedAllocate(size_t bytes) {
+    bytes = max<size_t>(bytes, 1);
+    while (true) {
+        if (void* memory = malloc(bytes)) {
+            g_alloc_tracker.recordAllocation(bytes);
+            return memory;
+        }
+        new_handler handler = get_new_handler();
+        if (!handler) {
+            throw bad_alloc();
+        }
+        handler();
+    }
+}
+
+static void* trackedAllocateAligned(size_t bytes, align_val_t alignment) {
+    size_t align = static_cast<size_t>(alignment);
+    bytes = (max<size_t>(bytes, 1) + align - 1) / align * align; // aligned_alloc wants a multiple
+    while (true) {
+#ifdef _WIN32
+        void* memory = _aligned_malloc(bytes, align);
+#else
+        void* memory = aligned_alloc(align, bytes);
+#endif
+        if (memory) {
+            g_alloc_tracker.recordAllocation(bytes);
+            return memory;
+        }
+        new_handler handler = get_new_handler();
+        if (!handler) {
+            throw bad_alloc();
+        }
+        handler();
+    }
+}
+
+static void trackedFreeAligned(void* memory) {
+#ifdef _WIN32
+    _aligned_free(memory);
+#else
+    free(memory);
+#endif
+}
+
+void* operator new(size_t bytes) { return trackedAllocate(bytes); }
+void* operator new[](size_t bytes) { return trackedAllocate(bytes); }
+void* operator new(size_t bytes, align_val_t alignment) { return trackedAllocateAligned(bytes, alignment); }
+void* operator new[](size_t bytes, align_val_t alignment) { return trackedAllocateAligned(bytes, alignment); }
+
+void* operator new(size_t bytes, const nothrow_t&) noexcept {
+    try {
+        return trackedAllocate(bytes);
+    } catch (...) {
+        return nullptr;
+    }
+}
+void* operator new[](size_t bytes, const nothrow_t&) noexcept {
+    try {
+        return trackedAllocate(bytes);
+    } catch (...) {
+        return nullptr;
+    }
+}
+void* operator new(size_t bytes, align_val_t alignment, const nothrow_t&) noexcept {
+    try {
+        return trackedAllocateAligned(bytes, alignment);
+    } catch (...) {
+        return nullptr;
+    }
+}
+void* operator new[](size_t bytes, align_val_t alignment, const nothrow_t&) noexcept {
+    try {
+        return trackedAllocateAligned(bytes, alignment);
+    } catch (...) {
+        return nullptr;
+    }
+}
+
+void operator delete(void* memory) noexcept { free(memory); }
+void operator delete[](void* memory) noexcept { free(memory); }
+void operator delete(void* memory, size_t) noexcept { free(memory); }
+void operator delete[](void* memory, size_t) noexcept { free(memory); }
+void operator delete(void* memory, const nothrow_t&) noexcept { free(memory); }
+void operator delete[](void* memory, const nothrow_t&) noexcept { free(memory); }
+void operator delete(void* memory, align_val_t) noexcept { trackedFreeAligned(memory); }
+void operator delete[](void* memory, align_val_t) noexcept { trackedFreeAligned(memory); }
+void operator delete(void* memory, size_t, align_val_t) noexcept { trackedFreeAligned(memory); }
+void operator delete[](void* memory, size_t, align_val_t) noexcept { trackedFreeAligned(memory); }
+void operator delete(void* memory, align_val_t, const nothrow_t&) noexcept { trackedFreeAligned(memory); }
+void operator delete[](void* memory, align_val_t, const nothrow_t&) noexcept { trackedFreeAligned(memory); }
@@ -0,0 +1,85 @@
+#pragma once
+#include <bits/stdc++.h>
+
+using namespace std;
+
+// Heap-allocation accounting per order stage.
+//
+// alloc_tracker.cpp replaces the global operator new/delete. Every thread
+// carries the stage it is currently working on (set with AllocationScope);
+// allocations made inside a scope are counted against that stage, anything
+// else only costs a thread-local load and a branch. Scopes nest, and the
+// innermost one wins, so STATUS_LINE inside DELIVER counts the formatting of
+// the delivery message on its own.
+
+enum class AllocationStage {
+    NONE,
+    PLACE_ORDER,   // customer creates, pays for and queues an order
+    PREPARE,
+    COOK,
+    COMPLETE,      // chef marks ready and hands over to delivery
+    DELIVER,
+    REFUND,
+    STATUS_LINE,   // building and printing one status message
+    COUNT
+};
+
+constexpr int ALLOCATION_STAGE_COUNT = static_cast<int>(AllocationStage::COUNT);
+
+struct AllocationCounts {
+    uint64_t passes = 0;       // scopes entered
+    uint64_t allocations = 0;
+    uint64_t bytes = 0;
+};
+
+class AllocationTracker {
+private:
+    struct alignas(64) StageCounters {
+        atomic<uint64_t> passes{0};
+        atomic<uint64_t> allocations{0};
+        atomic<uint64_t> bytes{0};
+    };
+
+    StageCounters stages[ALLOCATION_STAGE_COUNT];
+
+    static thread_local AllocationStage current_stage;
+
+    friend class AllocationScope;
+
+public:
+    // Called from operator new
+    void recordAllocation(size_t bytes) {
+        AllocationStage stage = current_stage;
+        if (stage != AllocationStage::NONE) {
+            StageCounters& counters = stages[static_cast<int>(stage)];
+            counters.allocations.fetch_add(1, memory_order_relaxed);
+            counters.bytes.fetch_add(bytes, memory_order_relaxed);
+        }
+    }
+
+    AllocationCounts getCounts(AllocationStage stage) const;
+
+    // Allocations and bytes per pass for every stage that was entered
+    void printReport(ostream& out) const;
+};
+
+// Global tracker fed by the replaced operator new
+extern AllocationTracker g_alloc_tracker;
+
+// Attributes the calling thread's allocations to `stage` until destroyed
+class AllocationScope {
+private:
+    AllocationStage previous;
+
+public:
+    explicit AllocationScope(AllocationStage stage) : previous(AllocationTracker::current_stage) {
+        g_alloc_tracker.stages[static_cast<int>(stage)].passes.fetch_add(1, memory_order_relaxed);
+        AllocationTracker::current_stage = stage;
+    }
+    ~AllocationScope() { AllocationTracker::current_stage = previous; }
+
+    AllocationScope(const AllocationScope&) = delete;
+    AllocationScope& operator=(const AllocationScope&) = delete;
+};
+
+string allocationStageToString(AllocationStage stage);
@@ -0,0 +1,155 @@
+#include <bits/stdc++.h>
+#include "availability.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+using namespace std;
+
+// Lanes for ingredients an item does not use; larger than any real count
+static constexpr float UNCONSTRAINED = 1e9f;
+
+// AvailabilityEngine implementation
+AvailabilityEngine::AvailabilityEngine(const MenuCatalog& catalog)
+    : item_count(catalog.getItemCount()), ingredient_count(catalog.getIngredientCount()),
+      stride((catalog.getIngredientCount() + LANES - 1) / LANES * LANES),
+      requirements(item_count * stride, 0), inverse_requirements(item_count * stride, 0.0f),
+      stock_scratch(stride, 0.0f), use_avx2(false) {
+    for (size_t item = 0; item < item_count; ++item) {
+        auto id = static_cast<MenuItemId>(item);
+        const IngredientId* ingredients = catalog.getRecipeIngredients(id);
+        const uint16_t* quantities = catalog.getRecipeQuantities(id);
+        for (size_t r = 0; r < catalog.getRecipeSize(id); ++r) {
+            requirements[item * stride + ingredients[r]] = quantities[r];
+            inverse_requirements[item * stride + ingredients[r]] = 1.0f / quantities[r];
+        }
+    }
+    setUseSimd(true);
+}
+
+void AvailabilityEngine::setUseSimd(bool enabled) {
+#if defined(__x86_64__) || defined(__i386__)
+    use_avx2 = enabled && __builtin_cpu_supports("avx2");
+#else
+    (void)enabled;
+    use_avx2 = false;
+#endif
+}
+
+void AvailabilityEngine::loadStock(const Inventory& inventory, vector<int32_t>& stock) const {
+    stock.assign(stride, 0);
+    for (size_t i = 0; i < ingredient_count; ++i) {
+        stock[i] = inventory.getQuantity(static_cast<IngredientId>(i));
+    }
+}
+
+void AvailabilityEngine::computeItemCounts(const int32_t* stock, int32_t* counts) const {
+#if defined(__x86_64__) || defined(__i386__)
+    if (use_avx2) {
+        computeItemCountsAvx2(stock, counts);
+        return;
+    }
+#endif
+    computeItemCountsScalar(stock, counts);
+}
+
+size_t AvailabilityEngine::planQueue(int32_t* stock, const MenuItemId* items, size_t n, uint8_t* makeable) const {
+#if defined(__x86_64__) || defined(__i386__)
+    if (use_avx2) {
+        return planQueueAvx2(stock, items, n, makeable);
+    }
+#endif
+    return planQueueScalar(stock, items, n, makeable);
+}
+
+// count = min over used ingredients of floor(stock / req). The division is a
+// multiply by the precomputed reciprocal; evaluating at stock + 0.5 keeps exact
+// multiples from rounding down (exact while stock stays below ~2 million).
+void AvailabilityEngine::computeItemCountsScalar(const int32_t* stock, int32_t* counts) const {
+    for (size_t item = 0; item < item_count; ++item) {
+        const float* inverse = inverse_requirements.data() + item * stride;
+        float best = UNCONSTRAINED;
+        for (size_t i = 0; i < stride; ++i) {
+            float quotient = inverse[i] == 0.0f ? UNCONSTRAINED : (stock[i] + 0.5f) * inverse[i];
+            best = min(best, quotient);
+        }
+        counts[item] = static_cast<int32_t>(max(0.0f, best));
+    }
+}
+
+size_t AvailabilityEngine::planQueueScalar(int32_t* stock, const MenuItemId* items, size_t n, uint8_t* makeable) const {
+    size_t total = 0;
+    for (size_t k = 0; k < n; ++k) {
+        const int32_t* required = requirements.data() + items[k] * stride;
+        bool fits = true;
+        for (size_t i = 0; i < stride; ++i) {
+            fits &= stock[i] >= required[i];
+        }
+        makeable[k] = fits;
+        if (fits) {
+            for (size_t i = 0; i < stride; ++i) {
+                stock[i] -= required[i];
+            }
+            total++;
+        }
+    }
+    return total;
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+__attribute__((target("avx2")))
+void AvailabilityEngine::computeItemCountsAvx2(const int32_t* stock, int32_t* counts) const {
+    const __m256 half = _mm256_set1_ps(0.5f);
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 unconstrained = _mm256_set1_ps(UNCONSTRAINED);
+
+    // Stock as float once per scan, shared by every row
+    float* stock_plus_half = stock_scratch.data();
+    for (size_t i = 0; i < stride; i += LANES) {
+        __m256 s = _mm256_cvtepi32_ps(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(stock + i)));
+        _mm256_storeu_ps(stock_plus_half + i, _mm256_add_ps(s, half));
+    }
+
+    for (size_t item = 0; item < item_count; ++item) {
+        const float* inverse = inverse_requirements.data() + item * stride;
+        __m256 best = unconstrained;
+        for (size_t i = 0; i < stride; i += LANES) {
+            __m256 inv = _mm256_loadu_ps(inverse + i);
+            __m256 quotient = _mm256_mul_ps(_mm256_loadu_ps(stock_plus_half + i), inv);
+            quotient = _mm256_blendv_ps(quotient, unconstrained, _mm256_cmp_ps(inv, zero, _CMP_EQ_OQ));
+            best = _mm256_min_ps(best, quotient);
+        }
+        // Horizontal min of the eight lanes
+        __m128 low = _mm_min_ps(_mm256_castps256_ps128(best), _mm256_extractf128_ps(best, 1));
+        low = _mm_min_ps(low, _mm_movehl_ps(low, low));
+        low = _mm_min_ss(low, _mm_shuffle_ps(low, low, 1));
+        counts[item] = static_cast<int32_t>(max(0.0f, _mm_cvtss_f32(low)));
+    }
+}
+
+__attribute__((target("avx2")))
+size_t AvailabilityEngine::planQueueAvx2(int32_t* stock, const MenuItemId* items, size_t n, uint8_t* makeable) const {
+    size_t total = 0;
+    for (size_t k = 0; k < n; ++k) {
+        const int32_t* required = requirements.data() + items[k] * stride;
+        __m256i short_lanes = _mm256_setzero_si256();
+        for (size_t i = 0; i < stride; i += LANES) {
+            __m256i s = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(stock + i));
+            __m256i r = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(required + i));
+            short_lanes = _mm256_or_si256(short_lanes, _mm256_cmpgt_epi32(r, s));
+        }
+        bool fits = _mm256_testz_si256(short_lanes, short_lanes);
+        makeable[k] = fits;
+        if (fits) {
+            for (size_t i = 0; i < stride; i += LANES) {
+                __m256i s = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(stock + i));
+                __m256i r = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(required + i));
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(stock + i), _mm256_sub_epi32(s, r));
+            }
+            total++;
+        }
+    }
+    return total;
+}
+#endif
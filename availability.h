@@ -0,0 +1,53 @@
+#pragma once
+#include <bits/stdc++.h>
+#include "catalog.h"
+
+using namespace std;
+
+// "What can we make right now" over the whole menu or the whole order queue.
+//
+// Recipe requirements are expanded into a dense items x ingredients matrix
+// (rows padded to a multiple of 8 lanes) so a scan is a straight run of SIMD
+// min/compare operations instead of per-recipe pointer chasing. AVX2 is used
+// when the CPU supports it, with a scalar fallback that produces identical
+// results.
+class AvailabilityEngine {
+private:
+    static constexpr size_t LANES = 8;
+
+    size_t item_count;
+    size_t ingredient_count;
+    size_t stride;                      // ingredient_count rounded up to LANES
+    vector<int32_t> requirements;       // item_count x stride, 0 = not used
+    vector<float> inverse_requirements; // 1/req, 0 where the item does not use the ingredient
+    mutable vector<float> stock_scratch; // stride floats, reused by every AVX2 scan
+    bool use_avx2;
+
+    void computeItemCountsScalar(const int32_t* stock, int32_t* counts) const;
+    size_t planQueueScalar(int32_t* stock, const MenuItemId* items, size_t n, uint8_t* makeable) const;
+#if defined(__x86_64__) || defined(__i386__)
+    void computeItemCountsAvx2(const int32_t* stock, int32_t* counts) const;
+    size_t planQueueAvx2(int32_t* stock, const MenuItemId* items, size_t n, uint8_t* makeable) const;
+#endif
+
+public:
+    explicit AvailabilityEngine(const MenuCatalog& catalog);
+
+    size_t getItemCount() const { return item_count; }
+    size_t getStride() const { return stride; }
+    bool usesSimd() const { return use_avx2; }
+    void setUseSimd(bool enabled);
+
+    // Copies current stock into `stock` (resized to getStride(), pad lanes 0)
+    void loadStock(const Inventory& inventory, vector<int32_t>& stock) const;
+
+    // counts[i] = how many of menu item i could be made from `stock` alone.
+    // Uses the engine's scratch buffer: one scan at a time per engine (the
+    // pizzeria scans under order_queue_mutex).
+    void computeItemCounts(const int32_t* stock, int32_t* counts) const;
+
+    // Greedy FIFO admission over a queue of orders: makeable[k] is 1 if order
+    // k can be made after every earlier makeable order has taken its share.
+    // `stock` is consumed in place. Returns the number of makeable orders.
+    size_t planQueue(int32_t* stock, const MenuItemId* items, size_t n, uint8_t* makeable) const;
+};
@@ -0,0 +1,1079 @@
+#include <bits/stdc++.h>
+#include "alloc_tracker.h"
+#include "availability.h"
+#include "catalog.h"
+#include "estimator.h"
+#include "order_history.h"
+#include "order_index.h"
+#include "pizzeria.h"
+#include "placement.h"
+#include "status_line.h"
+#include "tracer.h"
+using namespace std;
+
+// pizzeria_bench - microbenchmarks for the pizzeria's data structures.
+//
+//   pizzeria_bench <benchmark> [--key value ...]
+//   pizzeria_bench list
+
+using BenchOptions = map<string, string>;
+
+static long optionInt(const BenchOptions& options, const string& key, long fallback) {
+    auto it = options.find(key);
+    return it == options.end() ? fallback : atol(it->second.c_str());
+}
+
+template <typename F>
+static double timeSeconds(F&& body) {
+    auto start = chrono::steady_clock::now();
+    body();
+    return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+static void printHeader(const string& title) {
+    cout << "\n" << string(60, '=') << endl;
+    cout << title << endl;
+    cout << string(60, '=') << endl;
+}
+
+static void printResult(const string& name, double value, const string& unit) {
+    cout << "  " << left << setw(38) << name << right << setw(14) << fixed << setprecision(1)
+         << value << " " << unit << endl;
+}
+
+// Synthetic menu file: every pizza uses dough/cheese/sauce plus 2-10 toppings
+static string generateMenu(int items, int ingredients, uint32_t seed) {
+    mt19937 gen(seed);
+    uniform_int_distribution<> topping(3, ingredients - 1);
+    uniform_int_distribution<> topping_count(2, 10);
+    uniform_int_distribution<> quantity(1, 3);
+    uniform_int_distribution<> stock(50, 500);
+
+    ostringstream out;
+    out << "# generated: " << items << " pizzas, " << ingredients << " ingredients\n";
+    for (int i = 0; i < ingredients; ++i) {
+        out << "ingredient | Ingredient " << i << " | " << stock(gen) << "\n";
+    }
+    for (int i = 0; i < items; ++i) {
+        out << "pizza | Pizza " << i << " | " << 10 + i % 15 << ".99 | Ingredient 0, Ingredient 1, Ingredient 2";
+        for (int t = topping_count(gen); t > 0; --t) {
+            out << ", Ingredient " << topping(gen) << ":" << quantity(gen);
+        }
+        out << "\n";
+    }
+    return out.str();
+}
+
+// Catalog load, recipe checks and reservations at menu scale
+static void benchCatalog(const BenchOptions& options) {
+    int items = optionInt(options, "items", 500);
+    int ingredients = max(4L, optionInt(options, "ingredients", 200));
+    long operations = optionInt(options, "ops", 2000000);
+    int threads = optionInt(options, "threads", max(4u, thread::hardware_concurrency()));
+
+    string menu = generateMenu(items, ingredients, 42);
+    printHeader("CATALOG BENCHMARK (" + to_string(items) + " pizzas, " + to_string(ingredients) +
+                " ingredients, " + to_string(menu.size() / 1024) + " KiB menu)");
+
+    const int load_runs = 20;
+    MenuCatalog catalog;
+    double load_seconds = timeSeconds([&] {
+        for (int r = 0; r < load_runs; ++r) {
+            istringstream in(menu);
+            catalog = MenuCatalog::loadFromStream(in, "generated");
+        }
+    });
+    printResult("Menu load + index build", load_seconds / load_runs * 1e3, "ms");
+
+    double inventory_seconds = timeSeconds([&] {
+        for (int r = 0; r < load_runs; ++r) {
+            Inventory inventory(catalog);
+        }
+    });
+    printResult("Inventory setup", inventory_seconds / load_runs * 1e6, "us");
+
+    size_t recipe_entries = 0;
+    for (size_t i = 0; i < catalog.getItemCount(); ++i) {
+        recipe_entries += catalog.getRecipeSize(static_cast<MenuItemId>(i));
+    }
+    printResult("Average recipe size", static_cast<double>(recipe_entries) / catalog.getItemCount(), "ingredients");
+
+    // Pre-generated item sequence so RNG cost stays out of the timings
+    vector<MenuItemId> sequence(1 << 16);
+    mt19937 gen(7);
+    uniform_int_distribution<> pick(0, items - 1);
+    for (auto& item : sequence) {
+        item = static_cast<MenuItemId>(pick(gen));
+    }
+    size_t mask = sequence.size() - 1;
+
+    Inventory inventory(catalog);
+    long makeable = 0;
+    double check_seconds = timeSeconds([&] {
+        for (long i = 0; i < operations; ++i) {
+            makeable += inventory.canMake(catalog, sequence[i & mask]);
+        }
+    });
+    printResult("Recipe check (canMake)", check_seconds / operations * 1e9, "ns/op");
+
+    long reserved = 0;
+    double reserve_seconds = timeSeconds([&] {
+        for (long i = 0; i < operations; ++i) {
+            MenuItemId item = sequence[i & mask];
+            if (inventory.reserve(catalog, item)) {
+                inventory.release(catalog, item);
+                reserved++;
+            }
+        }
+    });
+    printResult("Reserve + release, 1 thread", reserve_seconds / operations * 1e9, "ns/op");
+
+    // Concurrent reservations against a stock that runs out and is topped up
+    Inventory shared(catalog);
+    atomic<long> successes{0}, failures{0};
+    long per_thread = operations / threads;
+    double concurrent_seconds = timeSeconds([&] {
+        vector<thread> workers;
+        for (int t = 0; t < threads; ++t) {
+            workers.emplace_back([&, t] {
+                long ok = 0, failed = 0;
+                for (long i = 0; i < per_thread; ++i) {
+                    MenuItemId item = sequence[(i * 7 + t * 4099) & mask];
+                    if (shared.reserve(catalog, item)) {
+                        ok++;
+                        if (i % 3 != 0) {
+                            shared.release(catalog, item);
+                        }
+                    } else {
+                        failed++;
+                        const IngredientId* recipe = catalog.getRecipeIngredients(item);
+                        for (size_t r = 0; r < catalog.getRecipeSize(item); ++r) {
+                            shared.restock(recipe[r], 10);
+                        }
+                    }
+                }
+                successes += ok;
+                failures += failed;
+            });
+        }
+        for (auto& worker : workers) worker.join();
+    });
+    printResult("Reserve, " + to_string(threads) + " threads",
+                (per_thread * threads) / concurrent_seconds / 1e6, "M ops/s");
+    printResult("  successful reservations", successes.load() * 100.0 / (per_thread * threads), "%");
+
+    // Keep the optimiser honest
+    if (makeable < 0 || reserved < 0) cout << "";
+}
+
+// Makeable-now scans over the menu and a large order queue, SIMD vs scalar
+static void benchAvailability(const BenchOptions& options) {
+    int items = optionInt(options, "items", 500);
+    int ingredients = max(4L, optionInt(options, "ingredients", 200));
+    long queued = optionInt(options, "queue", 5000);
+    int rounds = optionInt(options, "rounds", 200);
+
+    istringstream menu(generateMenu(items, ingredients, 42));
+    MenuCatalog catalog = MenuCatalog::loadFromStream(menu, "generated");
+    Inventory inventory(catalog);
+    AvailabilityEngine engine(catalog);
+
+    printHeader("AVAILABILITY BENCHMARK (" + to_string(items) + " pizzas, " + to_string(ingredients) +
+                " ingredients, " + to_string(queued) + " queued orders)");
+    cout << "  AVX2 available: " << (engine.usesSimd() ? "yes" : "no") << endl;
+
+    mt19937 gen(11);
+    uniform_int_distribution<> pick(0, items - 1);
+    vector<MenuItemId> queue(queued);
+    for (auto& item : queue) {
+        item = static_cast<MenuItemId>(pick(gen));
+    }
+
+    vector<int32_t> stock;
+    engine.loadStock(inventory, stock);
+    vector<int32_t> counts(items), reference_counts(items);
+    vector<uint8_t> makeable(queued), reference_makeable(queued);
+    vector<int32_t> scratch;
+    size_t planned = 0, reference_planned = 0;
+
+    auto run = [&](bool simd, vector<int32_t>& out_counts, vector<uint8_t>& out_makeable, size_t& out_planned) {
+        engine.setUseSimd(simd);
+        double count_seconds = timeSeconds([&] {
+            for (int r = 0; r < rounds; ++r) {
+                engine.computeItemCounts(stock.data(), out_counts.data());
+            }
+        });
+        double plan_seconds = timeSeconds([&] {
+            for (int r = 0; r < rounds; ++r) {
+                scratch = stock;
+                out_planned = engine.planQueue(scratch.data(), queue.data(), queue.size(), out_makeable.data());
+            }
+        });
+        string label = simd ? "SIMD" : "scalar";
+        printResult("Menu counts, " + label, count_seconds / rounds * 1e6, "us/scan");
+        printResult("Queue plan, " + label, plan_seconds / rounds * 1e6, "us/scan");
+        printResult("  per queued order", plan_seconds / rounds / queued * 1e9, "ns");
+    };
+
+    run(false, reference_counts, reference_makeable, reference_planned);
+    engine.setUseSimd(true);
+    if (engine.usesSimd()) {
+        run(true, counts, makeable, planned);
+        bool identical = counts == reference_counts && makeable == reference_makeable;
+        cout << "  SIMD results match scalar: " << (identical ? "yes" : "NO") << endl;
+    }
+
+    // Baseline: the old pop-and-fail approach checks recipes one order at a time
+    double naive_seconds = timeSeconds([&] {
+        for (int r = 0; r < rounds; ++r) {
+            long hits = 0;
+            for (auto item : queue) {
+                hits += inventory.canMake(catalog, item);
+            }
+            if (hits < 0) cout << "";
+        }
+    });
+    printResult("Per-order canMake loop (baseline)", naive_seconds / rounds * 1e6, "us/scan");
+    printResult("Makeable after FIFO allocation", reference_planned, "orders");
+}
+
+// Accepts and drops everything written to it, so console formatting is
+// measured without terminal I/O
+class DiscardBuffer : public streambuf {
+protected:
+    int overflow(int c) override { return traits_type::not_eof(c); }
+    streamsize xsputn(const char*, streamsize count) override { return count; }
+};
+
+// Drives orders through the real Pizzeria queue/status path without the
+// simulated sleeps, optionally printing the status lines each real order
+// prints (through printOrderStatus into a DiscardBuffer)
+static double runOrderPipeline(Pizzeria& pizzeria, long orders, bool print_status_lines) {
+    auto print = [&](const StatusLine& line) {
+        if (print_status_lines) {
+            pizzeria.printOrderStatus(line.view());
+        }
+    };
+    auto announce = [&](string_view action, const Order& order) {
+        StatusLine line;
+        line << "Chef 1 (Mario) " << action << " Order #" << order.getOrderId() << " ("
+             << g_catalog.getItemName(order.getMenuItem()) << ")";
+        print(line);
+    };
+
+    return timeSeconds([&] {
+        for (long i = 0; i < orders; ++i) {
+            auto order = make_shared<Order>(1, static_cast<MenuItemId>(i % g_catalog.getItemCount()));
+            pizzeria.addOrder(order);
+            if (i % 4 == 0) {
+                pizzeria.restockIngredients(); // at least 5 units of everything, so dispatch never waits
+            }
+            auto next = pizzeria.getNextTask().order;
+            pizzeria.setOrderStatus(next, OrderStatus::PREPARING);
+            announce("started preparing", *next);
+            pizzeria.setOrderStatus(next, OrderStatus::COOKING);
+            announce("is cooking", *next);
+            auto ready_at = g_sim_clock.now();
+            pizzeria.setOrderStatus(next, OrderStatus::READY, ready_at);
+            next->markReady(ready_at);
+            announce("completed", *next);
+            pizzeria.addReadyOrder(next);
+            auto ready = pizzeria.getReadyOrder();
+            pizzeria.setOrderStatus(ready, OrderStatus::OUT_FOR_DELIVERY);
+            auto delivered_at = g_sim_clock.now();
+            ready->markCompleted(delivered_at);
+            pizzeria.setOrderStatus(ready, OrderStatus::DELIVERED, delivered_at);
+            pizzeria.settleDelivery(ready);
+            StatusLine line;
+            line << "DELIVERY: Order #" << ready->getOrderId() << " delivered to Customer " << ready->getCustomerId()
+                 << " ($" << Dollars{ready->getPrice()} << ") - Processing time: "
+                 << Decimal{ready->getProcessingTime()} << "s";
+            print(line);
+        }
+    });
+}
+
+// Wall time of a whole virtual-time day (3 chefs, 5 customers) with its log
+// discarded: every real thread, queue and status line, without the sleeps
+static double timeVirtualDay(uint64_t seed) {
+    SimRandom::setMasterSeed(seed);
+    g_sim_clock.setVirtual(true);
+    ios console_format(nullptr);
+    console_format.copyfmt(cout);
+    DiscardBuffer discard;
+    streambuf* console = cout.rdbuf(&discard);
+    double seconds = timeSeconds([] {
+        g_pizzeria = make_unique<Pizzeria>(3, 5);
+        g_pizzeria->startOperations();
+        g_pizzeria.reset();
+    });
+    cout.rdbuf(console);
+    cout.clear();
+    cout.copyfmt(console_format);
+    g_sim_clock.setVirtual(false);
+    return seconds;
+}
+
+// Span recording cost and its overhead on the order hot path
+static void benchTracing(const BenchOptions& options) {
+    long orders = optionInt(options, "orders", 100000);
+    long spans = optionInt(options, "spans", 1000000);
+    long days = optionInt(options, "days", 5);
+
+    printHeader("TRACING OVERHEAD BENCHMARK (" + to_string(orders) + " orders)");
+
+    Tracer tracer(spans + 1);
+    double disabled_seconds = timeSeconds([&] {
+        for (long i = 0; i < spans; ++i) {
+            tracer.recordSpan("span", i, i + 1, 1);
+        }
+    });
+    tracer.enable();
+    double enabled_seconds = timeSeconds([&] {
+        for (long i = 0; i < spans; ++i) {
+            tracer.recordSpan("span", i, i + 1, 1);
+        }
+    });
+    printResult("recordSpan, tracing disabled", disabled_seconds / spans * 1e9, "ns");
+    printResult("recordSpan, tracing enabled", enabled_seconds / spans * 1e9, "ns");
+
+    Pizzeria pizzeria(1, 0);
+    pizzeria.restockIngredients();
+    ios console_format(nullptr);
+    console_format.copyfmt(cout);
+    DiscardBuffer discard;
+    streambuf* console = cout.rdbuf(&discard);
+    runOrderPipeline(pizzeria, orders / 10, true); // warm up allocators and caches
+    cout.rdbuf(console);
+    cout.copyfmt(console_format);
+
+    // Bare queue/status/metrics path, and the same path with the status
+    // lines every real order prints (simulated sleeps excluded)
+    for (bool print_status_lines : {false, true}) {
+        console = cout.rdbuf(&discard);
+        g_tracer.disable();
+        double off_seconds = runOrderPipeline(pizzeria, orders, print_status_lines);
+        g_tracer.clear();
+        g_tracer.enable();
+        double on_seconds = runOrderPipeline(pizzeria, orders, print_status_lines);
+        g_tracer.disable();
+        cout.rdbuf(console);
+        cout.copyfmt(console_format);
+        size_t events = g_tracer.getEventCount();
+
+        string label = print_status_lines ? "Order path + status lines" : "Order pipeline";
+        printResult(label + ", tracing off", off_seconds / orders * 1e9, "ns/order");
+        printResult(label + ", tracing on", on_seconds / orders * 1e9, "ns/order");
+        printResult("  events recorded per order", static_cast<double>(events) / orders, "");
+        printResult("  added by tracing", (on_seconds - off_seconds) / orders * 1e9, "ns/order");
+        printResult("  overhead", (on_seconds - off_seconds) / off_seconds * 100.0, "%");
+    }
+
+    string path = "/tmp/pizzeria_bench_trace.json";
+    double export_seconds = timeSeconds([&] { g_tracer.writeChromeTrace(path); });
+    printResult("Chrome JSON export", export_seconds * 1e3, "ms");
+
+    // The whole shop, alternating untraced and traced days with the same seeds
+    double off_day_seconds = 0;
+    double on_day_seconds = 0;
+    for (long day = 0; day < days; ++day) {
+        g_tracer.disable();
+        off_day_seconds += timeVirtualDay(day + 1);
+        g_tracer.clear();
+        g_tracer.enable();
+        on_day_seconds += timeVirtualDay(day + 1);
+        g_tracer.disable();
+    }
+    printResult("Virtual-time day, tracing off", off_day_seconds / days * 1e3, "ms/day");
+    printResult("Virtual-time day, tracing on", on_day_seconds / days * 1e3, "ms/day");
+    printResult("  overhead", (on_day_seconds - off_day_seconds) / off_day_seconds * 100.0, "%");
+    g_tracer.clear();
+}
+
+// Appends synthetic finished orders, then times grouped aggregates with one
+// worker and with all cores, optionally with most segments spilled to a file
+static void fillHistory(OrderHistory& history, long orders) {
+    mt19937 gen(23);
+    uniform_int_distribution<> item(0, 199), customer(0, 9999), ready(4000, 15000), delivery(800, 2500);
+    uniform_int_distribution<> price(999, 2499), refund(0, 49);
+    for (long i = 0; i < orders; ++i) {
+        HistoryRow row;
+        row.order_id = static_cast<uint32_t>(i + 1);
+        row.customer_id = static_cast<uint16_t>(customer(gen));
+        row.menu_item = static_cast<MenuItemId>(item(gen));
+        row.placed_ms = static_cast<uint32_t>(i / 10); // ten orders per millisecond
+        row.ready_delta_ms = static_cast<uint32_t>(ready(gen));
+        bool refunded = refund(gen) == 0;
+        row.delivered_delta_ms = refunded ? HISTORY_NO_TIME : row.ready_delta_ms + delivery(gen);
+        row.price_cents = static_cast<uint32_t>(price(gen));
+        row.flags = refunded ? HISTORY_FLAG_REFUNDED : HISTORY_FLAG_DELIVERED;
+        history.append(row);
+    }
+}
+
+static void benchHistoryQueries(const OrderHistory& history, long orders, unsigned threads) {
+    struct Query {
+        const char* name;
+        HistoryGroupBy group_by;
+    };
+    const Query queries[] = {
+        {"by pizza type", HistoryGroupBy::MENU_ITEM},
+        {"by customer", HistoryGroupBy::CUSTOMER},
+        {"by 1s time bucket", HistoryGroupBy::TIME_BUCKET},
+    };
+    for (const auto& query : queries) {
+        for (unsigned t : {1u, threads}) {
+            vector<HistoryAggregate> groups;
+            double seconds = timeSeconds([&] { groups = history.aggregate(query.group_by, chrono::seconds(1), t); });
+            printResult(string(query.name) + ", " + to_string(t) + " thread" + (t == 1 ? "" : "s"),
+                orders / seconds / 1e6, "M rows/s");
+            if (t == threads) {
+                break;
+            }
+        }
+    }
+}
+
+static void benchHistory(const BenchOptions& options) {
+    long orders = optionInt(options, "orders", 5000000);
+    unsigned threads = static_cast<unsigned>(optionInt(options, "threads", max(1u, thread::hardware_concurrency())));
+    long resident = optionInt(options, "resident", 4);
+
+    printHeader("ORDER HISTORY BENCHMARK (" + to_string(orders) + " orders)");
+
+    OrderHistory history;
+    double append_seconds = timeSeconds([&] { fillHistory(history, orders); });
+    printResult("Append", orders / append_seconds / 1e6, "M rows/s");
+    printResult("  resident columns", history.getMemoryBytes() / 1e6, "MB");
+    printResult("  bytes per order", static_cast<double>(history.getMemoryBytes()) / orders, "");
+    benchHistoryQueries(history, orders, threads);
+
+    // Same data with all but `resident` segments in a memory-mapped file
+    OrderHistory spilled;
+    spilled.enableSpill("/tmp/pizzeria_bench_history.spill", resident);
+    double spill_seconds = timeSeconds([&] { fillHistory(spilled, orders); });
+    cout << "\n  With spill (" << resident << " resident segments):" << endl;
+    printResult("Append", orders / spill_seconds / 1e6, "M rows/s");
+    printResult("  resident columns", spilled.getMemoryBytes() / 1e6, "MB");
+    printResult("  spilled segments", static_cast<double>(spilled.getSpilledSegments()), "");
+    benchHistoryQueries(spilled, orders, threads);
+
+    auto a = history.aggregate(HistoryGroupBy::MENU_ITEM);
+    auto b = spilled.aggregate(HistoryGroupBy::MENU_ITEM);
+    bool same = a.size() == b.size();
+    for (size_t i = 0; same && i < a.size(); ++i) {
+        same = a[i].revenue_cents == b[i].revenue_cents && a[i].delivered_ms_sum == b[i].delivered_ms_sum;
+    }
+    cout << "  Spilled results match: " << (same ? "yes" : "NO") << endl;
+
+    // 1 ms buckets over more than MAX_TIME_BUCKETS ms of orders would need a
+    // dense group per millisecond in every worker
+    if (orders / 10 >= static_cast<long>(OrderHistory::MAX_TIME_BUCKETS)) {
+        bool rejected = false;
+        try {
+            history.aggregate(HistoryGroupBy::TIME_BUCKET, chrono::milliseconds(1));
+        } catch (const runtime_error&) {
+            rejected = true;
+        }
+        cout << "  1 ms buckets rejected: " << (rejected ? "yes" : "NO") << endl;
+    }
+}
+
+// Baseline for the index benchmark: the obvious reader-writer-locked map
+class LockedStatusMap {
+    shared_mutex map_mutex;
+    unordered_map<uint32_t, uint8_t> statuses;
+
+public:
+    void insert(uint32_t order_id, uint8_t status) {
+        unique_lock<shared_mutex> lock(map_mutex);
+        statuses[order_id] = status;
+    }
+    bool update(uint32_t order_id, uint8_t status) {
+        unique_lock<shared_mutex> lock(map_mutex);
+        auto it = statuses.find(order_id);
+        if (it == statuses.end()) {
+            return false;
+        }
+        it->second = status;
+        return true;
+    }
+    bool remove(uint32_t order_id) {
+        unique_lock<shared_mutex> lock(map_mutex);
+        return statuses.erase(order_id) > 0;
+    }
+    optional<uint8_t> lookup(uint32_t order_id) {
+        shared_lock<shared_mutex> lock(map_mutex);
+        auto it = statuses.find(order_id);
+        return it == statuses.end() ? nullopt : optional<uint8_t>(it->second);
+    }
+};
+
+// Writers walk orders through placed -> cooking -> ready -> removed in a
+// rolling window of `window` live ids while readers look up random ids in it.
+// Returns {lookups/s, writes/s}.
+template <class Index>
+static pair<double, double> runIndexWorkload(Index& index, int readers, int writers, long window, double seconds) {
+    atomic<bool> stop{false};
+    atomic<uint64_t> lookups{0}, writes{0};
+    atomic<uint32_t> next_id{1};
+    vector<thread> threads;
+
+    for (int w = 0; w < writers; ++w) {
+        threads.emplace_back([&] {
+            uint64_t done = 0;
+            while (!stop.load(memory_order_relaxed)) {
+                uint32_t id = next_id.fetch_add(1, memory_order_relaxed);
+                index.insert(id, 0);
+                index.update(id, 1);
+                index.update(id, 2);
+                if (id > static_cast<uint32_t>(window)) {
+                    index.remove(id - static_cast<uint32_t>(window));
+                }
+                done += 4;
+            }
+            writes += done;
+        });
+    }
+    for (int r = 0; r < readers; ++r) {
+        threads.emplace_back([&, r] {
+            mt19937 gen(static_cast<uint32_t>(r + 1));
+            uint64_t done = 0, found = 0;
+            while (!stop.load(memory_order_relaxed)) {
+                uint32_t newest = next_id.load(memory_order_relaxed);
+                uint32_t id = newest - 1 - static_cast<uint32_t>(gen() % static_cast<uint32_t>(window));
+                found += index.lookup(id).has_value();
+                done++;
+            }
+            lookups += done;
+            (void)found;
+        });
+    }
+
+    double elapsed = timeSeconds([&] {
+        this_thread::sleep_for(chrono::duration<double>(seconds));
+        stop = true;
+        for (auto& t : threads) {
+            t.join();
+        }
+    });
+    return {lookups / elapsed, writes / elapsed};
+}
+
+static void benchIndex(const BenchOptions& options) {
+    int readers = static_cast<int>(optionInt(options, "readers", 4));
+    int writers = static_cast<int>(optionInt(options, "writers", 2));
+    long window = optionInt(options, "orders", 100000);
+    double seconds = optionInt(options, "seconds", 2);
+
+    printHeader("ORDER INDEX BENCHMARK (" + to_string(readers) + " readers, " + to_string(writers) +
+                " writers, " + to_string(window) + " live orders)");
+
+    OrderIndex index;
+    auto [index_lookups, index_writes] = runIndexWorkload(index, readers, writers, window, seconds);
+    printResult("Lock-free index lookups", index_lookups / 1e6, "M/s");
+    printResult("  writes", index_writes / 1e6, "M/s");
+    printResult("  rebuilds", static_cast<double>(index.getRebuilds()), "");
+    printResult("  final capacity", static_cast<double>(index.capacity()), "slots");
+
+    LockedStatusMap locked;
+    auto [locked_lookups, locked_writes] = runIndexWorkload(locked, readers, writers, window, seconds);
+    printResult("shared_mutex map lookups", locked_lookups / 1e6, "M/s");
+    printResult("  writes", locked_writes / 1e6, "M/s");
+    printResult("Lookup speedup", index_lookups / max(1.0, locked_lookups), "x");
+}
+
+// The four hot-path messages built the way they were before StatusLine:
+// to_string, substr and + concatenation
+static size_t formatMessagesWithStrings(int id, const string& name, string_view pizza, double price) {
+    auto dollars = [](double amount) { return to_string(amount).substr(0, to_string(amount).find('.') + 3); };
+    string chef = "Chef " + to_string(id) + " (" + name + ") started preparing Order #" + to_string(id) + " (" +
+                  string(pizza) + ")";
+    string payment = "PAYMENT: Customer " + to_string(id) + " (" + name + ") placed Order #" + to_string(id) +
+                     " for " + string(pizza) + " ($" + dollars(price) + ") - PAID";
+    string delivery = "DELIVERY: Order #" + to_string(id) + " delivered to Customer " + to_string(id) + " ($" +
+                      dollars(price) + ") - Processing time: " + to_string(price / 3) + "s";
+    string refund = "REFUND: Issued to Customer " + to_string(id) + " for Order #" + to_string(id) + ": $" +
+                    dollars(price * 1.1) + " (Original: $" + dollars(price) + " + 10% apology)";
+    return chef.size() + payment.size() + delivery.size() + refund.size();
+}
+
+static size_t formatMessagesWithStatusLine(int id, const string& name, string_view pizza, double price) {
+    StatusLine chef, payment, delivery, refund;
+    chef << "Chef " << id << " (" << name << ") started preparing Order #" << id << " (" << pizza << ")";
+    payment << "PAYMENT: Customer " << id << " (" << name << ") placed Order #" << id << " for " << pizza << " ($"
+            << Dollars{price} << ") - PAID";
+    delivery << "DELIVERY: Order #" << id << " delivered to Customer " << id << " ($" << Dollars{price}
+             << ") - Processing time: " << Decimal{price / 3} << "s";
+    refund << "REFUND: Issued to Customer " << id << " for Order #" << id << ": $" << Dollars{price * 1.1}
+           << " (Original: $" << Dollars{price} << " + 10% apology)";
+    return chef.view().size() + payment.view().size() + delivery.view().size() + refund.view().size();
+}
+
+// Cost and heap allocations of the order, payment, delivery and refund messages
+static void benchMessages(const BenchOptions& options) {
+    long rounds = optionInt(options, "rounds", 1000000);
+    printHeader("STATUS MESSAGE FORMATTING BENCHMARK (" + to_string(rounds) + " x 4 messages)");
+
+    string name = "Giuseppe";
+    string_view pizza = g_catalog.getItemName(0);
+    auto run = [&](const string& label, size_t (*format)(int, const string&, string_view, double)) {
+        AllocationCounts before = g_alloc_tracker.getCounts(AllocationStage::STATUS_LINE);
+        size_t checksum = 0;
+        double seconds = timeSeconds([&] {
+            AllocationScope scope(AllocationStage::STATUS_LINE);
+            for (long i = 0; i < rounds; ++i) {
+                checksum += format(static_cast<int>(i), name, pizza, 12.99 + static_cast<double>(i % 700));
+            }
+        });
+        AllocationCounts after = g_alloc_tracker.getCounts(AllocationStage::STATUS_LINE);
+        double messages = rounds * 4.0;
+        printResult(label, seconds / messages * 1e9, "ns/message");
+        printResult("  heap allocations", (after.allocations - before.allocations) / messages, "per message");
+        printResult("  heap bytes", (after.bytes - before.bytes) / messages, "per message");
+        return checksum;
+    };
+    size_t strings = run("std::string concatenation", formatMessagesWithStrings);
+    size_t fixed = run("StatusLine", formatMessagesWithStatusLine);
+    cout << "  Same text length: " << (strings == fixed ? "yes" : "NO") << endl;
+}
+
+// Checkpoint pause, write and mmap restore time at growing backlog sizes
+static void benchSnapshot(const BenchOptions& options) {
+    long max_orders = optionInt(options, "max-orders", 100000);
+    string path = (filesystem::temp_directory_path() / "pizzeria-bench.snap").string();
+    printHeader("SNAPSHOT BENCHMARK (up to " + to_string(max_orders) + " unfinished orders)");
+
+    for (long orders = 1000; orders <= max_orders; orders *= 10) {
+        SnapshotStats written, restored;
+        {
+            Pizzeria pizzeria(1, 0);
+            for (long i = 0; i < orders; ++i) {
+                pizzeria.addOrder(make_shared<Order>(static_cast<int>(i % 1000),
+                                                     static_cast<MenuItemId>(i % g_catalog.getItemCount())));
+            }
+            pizzeria.restockIngredients();
+            for (int chef = 0; chef < 4; ++chef) {
+                pizzeria.getNextTask(); // a few orders in the kitchen
+            }
+            written = pizzeria.writeSnapshot(path);
+        }
+        {
+            Pizzeria pizzeria(1, 0);
+            restored = pizzeria.restoreSnapshot(path);
+        }
+        double write_ms = chrono::duration<double, milli>(written.elapsed).count();
+        double restore_ms = chrono::duration<double, milli>(restored.elapsed).count();
+        cout << "  " << orders << " orders" << (restored.orders == written.orders ? "" : " (COUNT MISMATCH)") << endl;
+        printResult("  queue pause", chrono::duration<double, micro>(written.pause).count(), "us");
+        printResult("  write (incl. fsync)", write_ms, "ms");
+        printResult("  file size", written.bytes / 1e6, "MB");
+        printResult("  restore", restore_ms, "ms");
+        printResult("  restore per order", restore_ms * 1e6 / max<size_t>(1, restored.orders), "ns");
+    }
+    filesystem::remove(path);
+}
+
+// Cancellation without tombstones: find the order and erase it from the
+// middle of the deque, under the same single queue lock
+class LinearCancelQueue {
+    mutex queue_mutex;
+    deque<shared_ptr<Order>> queue;
+
+public:
+    void addOrder(shared_ptr<Order> order) {
+        lock_guard<mutex> lock(queue_mutex);
+        queue.push_back(move(order));
+    }
+    optional<double> cancelOrder(const shared_ptr<Order>& order) {
+        lock_guard<mutex> lock(queue_mutex);
+        auto it = find(queue.begin(), queue.end(), order);
+        if (it == queue.end()) {
+            return nullopt;
+        }
+        queue.erase(it);
+        return order->getPrice();
+    }
+};
+
+// Average time to cancel `cancels` random orders out of a backlog
+template <class Queue>
+static double timeBacklogCancels(Queue& queue, long backlog, long cancels) {
+    vector<shared_ptr<Order>> orders;
+    orders.reserve(backlog);
+    for (long i = 0; i < backlog; ++i) {
+        orders.push_back(make_shared<Order>(1, static_cast<MenuItemId>(i % g_catalog.getItemCount())));
+        queue.addOrder(orders.back());
+    }
+    shuffle(orders.begin(), orders.end(), mt19937(42));
+    long cancelled = 0;
+    double seconds = timeSeconds([&] {
+        for (long i = 0; i < cancels; ++i) {
+            cancelled += queue.cancelOrder(orders[i]).has_value();
+        }
+    });
+    if (cancelled != cancels) {
+        cout << "  (only " << cancelled << " of " << cancels << " cancels succeeded)" << endl;
+    }
+    return seconds / max(1L, cancels) * 1e9;
+}
+
+// Customers on every thread place orders and cancel every other one a few
+// orders later; returns {orders placed/s, cancels/s}
+template <class Queue>
+static pair<double, double> runCancelWorkload(Queue& queue, int threads, long orders_per_thread) {
+    atomic<long> cancelled{0};
+    double seconds = timeSeconds([&] {
+        vector<thread> workers;
+        for (int t = 0; t < threads; ++t) {
+            workers.emplace_back([&, t] {
+                shared_ptr<Order> recent[8];
+                long local_cancels = 0;
+                for (long i = 0; i < orders_per_thread; ++i) {
+                    auto order = make_shared<Order>(t + 1, static_cast<MenuItemId>(i % g_catalog.getItemCount()));
+                    queue.addOrder(order);
+                    auto& slot = recent[i % 8];
+                    if (slot && i % 2 == 0) {
+                        local_cancels += queue.cancelOrder(slot).has_value();
+                    }
+                    slot = move(order);
+                }
+                cancelled += local_cancels;
+            });
+        }
+        for (auto& worker : workers) {
+            worker.join();
+        }
+    });
+    return {threads * orders_per_thread / seconds, cancelled / seconds};
+}
+
+// A virtual-time day in which `percent` of customers cancel; returns the
+// kitchen and delivery drain times in seconds. Throws if the drain used up
+// most of DRAIN_BUDGET, which means cancelled orders were waited for.
+static pair<double, double> runCancellingDay(int percent, uint64_t seed) {
+    SimRandom::setMasterSeed(seed);
+    g_sim_clock.setVirtual(true);
+    ios console_format(nullptr);
+    console_format.copyfmt(cout);
+    streambuf* console = cout.rdbuf(nullptr); // the day's own log is discarded
+    g_pizzeria = make_unique<Pizzeria>(3, 5);
+    g_pizzeria->enableCancellations(percent);
+    g_pizzeria->startOperations();
+    const ShutdownCoordinator& shutdown = g_pizzeria->getShutdown();
+    double kitchen_s = chrono::duration<double>(shutdown.getPhaseDuration(ShutdownPhase::INTAKE_STOPPED)).count();
+    double delivery_s = chrono::duration<double>(shutdown.getPhaseDuration(ShutdownPhase::KITCHEN_DRAINED)).count();
+    g_pizzeria.reset();
+    cout.rdbuf(console);
+    cout.clear();
+    cout.copyfmt(console_format);
+    g_sim_clock.setVirtual(false);
+    if (kitchen_s + delivery_s >= chrono::duration<double>(DRAIN_BUDGET).count() / 2) {
+        throw runtime_error("drain with " + to_string(percent) + "% cancellations (seed " + to_string(seed) +
+                            ") took " + to_string(kitchen_s + delivery_s) + "s");
+    }
+    return {kitchen_s, delivery_s};
+}
+
+// Cancels a three-pizza order while one helper chef has its pizza in the oven
+// and another is still preparing: only the pizza in the oven keeps its
+// ingredients spent. Throws if stock is not conserved.
+static void checkMultiItemCancelStock() {
+    Pizzeria pizzeria(3, 0);
+    pizzeria.setParallelPrep(true);
+    pizzeria.restockIngredients(); // at least 5 units of everything
+    const Inventory& inventory = pizzeria.getInventory();
+    auto stock = [&] {
+        vector<int32_t> quantities(inventory.size());
+        for (size_t i = 0; i < quantities.size(); ++i) {
+            quantities[i] = inventory.getQuantity(static_cast<IngredientId>(i));
+        }
+        return quantities;
+    };
+    vector<int32_t> expected = stock();
+
+    MenuItemId items[3];
+    for (size_t i = 0; i < size(items); ++i) {
+        items[i] = static_cast<MenuItemId>(i % g_catalog.getItemCount());
+    }
+    auto order = make_shared<Order>(1, items, size(items));
+    pizzeria.addOrder(order);
+    PrepTask lead = pizzeria.getNextTask(); // reserves all three recipes
+    pizzeria.setOrderStatus(lead.order, OrderStatus::PREPARING);
+    PrepTask in_oven = pizzeria.claimTask(order);
+    PrepTask preparing = pizzeria.claimTask(order);
+    if (!lead || !in_oven || !preparing || !pizzeria.startCooking(in_oven)) {
+        throw runtime_error("multi-item cancel check: could not start the order");
+    }
+    if (!pizzeria.cancelOrder(order) || pizzeria.startCooking(preparing)) {
+        throw runtime_error("multi-item cancel check: cancel mid-preparation was not honoured");
+    }
+
+    MenuItemId cooked = order->getItem(in_oven.item);
+    for (size_t i = 0; i < g_catalog.getRecipeSize(cooked); ++i) {
+        expected[g_catalog.getRecipeIngredients(cooked)[i]] -= g_catalog.getRecipeQuantities(cooked)[i];
+    }
+    if (stock() != expected) {
+        throw runtime_error("multi-item cancel check: stock not conserved after cancelling mid-preparation");
+    }
+}
+
+static void benchCancel(const BenchOptions& options) {
+    long max_backlog = optionInt(options, "backlog", 100000);
+    long cancels = optionInt(options, "cancels", 1000);
+    int threads = static_cast<int>(optionInt(options, "threads", 4));
+    long orders = optionInt(options, "orders", 100000);
+    int rate = static_cast<int>(optionInt(options, "rate", 50));
+
+    printHeader("ORDER CANCELLATION BENCHMARK (" + to_string(cancels) + " cancels, up to " +
+                to_string(max_backlog) + " queued)");
+    for (long backlog = 1000; backlog <= max_backlog; backlog *= 10) {
+        cout << "  " << backlog << " queued orders" << endl;
+        {
+            Pizzeria pizzeria(1, 0);
+            printResult("  tombstone cancel", timeBacklogCancels(pizzeria, backlog, min(cancels, backlog)), "ns");
+        }
+        LinearCancelQueue linear;
+        printResult("  find + erase cancel", timeBacklogCancels(linear, backlog, min(cancels, backlog)), "ns");
+    }
+
+    cout << "  " << threads << " threads placing " << orders << " orders each, cancelling every other" << endl;
+    Pizzeria pizzeria(1, 0);
+    auto [placed, cancelled] = runCancelWorkload(pizzeria, threads, orders);
+    printResult("  orders placed", placed / 1e3, "K/s");
+    printResult("  cancels", cancelled / 1e3, "K/s");
+    LinearCancelQueue linear;
+    auto [linear_placed, linear_cancelled] = runCancelWorkload(linear, threads, orders);
+    printResult("  find + erase (queue only) placed", linear_placed / 1e3, "K/s");
+    printResult("  find + erase (queue only) cancels", linear_cancelled / 1e3, "K/s");
+
+    checkMultiItemCancelStock();
+    cout << "  multi-item cancel mid-preparation: stock conserved" << endl;
+
+    // Cancelled orders must not hold up closing
+    cout << "  virtual-time days with " << rate << "% of customers cancelling (seeds 1-5)" << endl;
+    double kitchen_s = 0;
+    double delivery_s = 0;
+    for (uint64_t seed = 1; seed <= 5; ++seed) {
+        auto [kitchen, delivery] = runCancellingDay(rate, seed);
+        kitchen_s = max(kitchen_s, kitchen);
+        delivery_s = max(delivery_s, delivery);
+    }
+    printResult("  longest kitchen drain", kitchen_s, "s");
+    printResult("  longest delivery drain", delivery_s, "s");
+}
+
+// Queueing-model estimate against simulating the same day
+static void benchEstimate(const BenchOptions& options) {
+    long rounds = optionInt(options, "rounds", 200);
+    printHeader("QUEUEING ESTIMATOR BENCHMARK (1-6 chefs x 1-10 customers, " + to_string(rounds) + " rounds)");
+
+    ShopModel model = ShopModel::fromCatalog(g_catalog, 1, 1);
+    double total_s = 0;
+    double slowest_s = 0;
+    double checksum = 0;
+    for (long round = 0; round < rounds; ++round) {
+        for (model.chefs = 1; model.chefs <= 6; ++model.chefs) {
+            for (model.customers = 1; model.customers <= 10; ++model.customers) {
+                ShopEstimate estimate = estimateShop(model);
+                double seconds = chrono::duration<double>(estimate.elapsed).count();
+                total_s += seconds;
+                slowest_s = max(slowest_s, seconds);
+                checksum += estimate.mean_order_to_delivered_s;
+            }
+        }
+    }
+    printResult("estimate (mean)", total_s / (rounds * 60) * 1e6, "us");
+    printResult("estimate (slowest)", slowest_s * 1e6, "us");
+
+    // One virtual-time simulation of a mid-size day, output discarded
+    model.chefs = 3;
+    model.customers = 5;
+    ostringstream discarded;
+    ObservedDay day = validateEstimate(discarded, model, 1, 42);
+    printResult("virtual-time simulation (3 chefs, 5 customers)", chrono::duration<double, milli>(day.elapsed).count(),
+                "ms");
+    cout << "  (checksum " << fixed << setprecision(1) << checksum << ")" << endl;
+}
+
+// Real order queues driven by pinned intake, chef, driver and restock threads.
+// Intake keeps at most `window` orders in flight, so latency measures the
+// hand-offs rather than a growing backlog. Returns {orders/s, latencies in us}.
+static pair<double, vector<double>> runPlacedKitchen(int chefs, int intake, long orders, long window,
+                                                     chrono::microseconds work) {
+    Pizzeria pizzeria(chefs, 0);
+    for (long i = 0; i < orders / 2 + 10; ++i) {
+        pizzeria.restockIngredients(); // at least 5 units per call, so chefs never wait for stock
+    }
+    atomic<long> placed{0};
+    atomic<long> delivered{0};
+    vector<double> latencies_us;
+
+    double seconds = timeSeconds([&] {
+        vector<thread> workers;
+        for (int c = 0; c < chefs; ++c) {
+            workers.emplace_back([&, c] {
+                g_placement.pinCurrentThread(WorkerRole::CHEF, c);
+                vector<uint64_t> scratch(4096, c); // per-chef working set, first touched after pinning
+                uint64_t sum = 0;
+                while (true) {
+                    PrepTask task = pizzeria.getNextTask();
+                    if (!task) {
+                        if (!pizzeria.isOpen()) break;
+                        continue;
+                    }
+                    pizzeria.setOrderStatus(task.order, OrderStatus::PREPARING);
+                    auto until = chrono::steady_clock::now() + work;
+                    for (size_t i = 0; chrono::steady_clock::now() < until; i = (i + 64) % scratch.size()) {
+                        sum += scratch[i]++;
+                    }
+                    pizzeria.setOrderStatus(task.order, OrderStatus::COOKING);
+                    auto now = g_sim_clock.now();
+                    pizzeria.setOrderStatus(task.order, OrderStatus::READY, now);
+                    task.order->markReady(now);
+                    pizzeria.addReadyOrder(task.order);
+                }
+                if (sum == 1) cout << "";
+            });
+        }
+        workers.emplace_back([&] {
+            g_placement.pinCurrentThread(WorkerRole::DRIVER, 0);
+            vector<double> local;
+            local.reserve(orders);
+            while (delivered.load() < orders) {
+                auto order = pizzeria.getReadyOrder();
+                if (!order) continue;
+                pizzeria.setOrderStatus(order, OrderStatus::OUT_FOR_DELIVERY);
+                auto now = g_sim_clock.now();
+                order->markCompleted(now);
+                pizzeria.setOrderStatus(order, OrderStatus::DELIVERED, now);
+                pizzeria.settleDelivery(order);
+                local.push_back(chrono::duration<double, micro>(order->getCompletionTime() -
+                                                                order->getOrderTime()).count());
+                delivered++;
+            }
+            latencies_us = move(local);
+            pizzeria.stopOperations();
+        });
+        workers.emplace_back([&] {
+            g_placement.pinCurrentThread(WorkerRole::SERVICE, 0);
+            while (pizzeria.isOpen()) {
+                pizzeria.restockIngredients();
+                this_thread::sleep_for(chrono::milliseconds(1));
+            }
+        });
+        for (int k = 0; k < intake; ++k) {
+            workers.emplace_back([&, k] {
+                g_placement.pinCurrentThread(WorkerRole::INTAKE, k);
+                while (true) {
+                    long id = placed++;
+                    if (id >= orders) break;
+                    while (id - delivered.load() >= window) {
+                        this_thread::yield();
+                    }
+                    auto item = static_cast<MenuItemId>(id % g_catalog.getItemCount());
+                    pizzeria.addOrder(make_shared<Order>(k + 1, item));
+                }
+            });
+        }
+        for (auto& worker : workers) {
+            worker.join();
+        }
+    });
+    return {orders / seconds, move(latencies_us)};
+}
+
+// Throughput and tail latency of the kitchen under each placement policy
+static void benchPlacement(const BenchOptions& options) {
+    long orders = optionInt(options, "orders", 20000);
+    int chefs = static_cast<int>(optionInt(options, "chefs", 4));
+    int intake = static_cast<int>(optionInt(options, "intake", 2));
+    long window = optionInt(options, "window", chefs * 4);
+    chrono::microseconds work(optionInt(options, "work-us", 20));
+
+    CpuTopology topology = CpuTopology::detect();
+    printHeader("THREAD PLACEMENT BENCHMARK (" + to_string(chefs) + " chefs, " + to_string(intake) + " intake, " +
+                to_string(orders) + " orders)");
+    cout << "  " << topology.describe() << endl;
+    if (topology.getCpuCount() <= 1) {
+        cout << "  (a single CPU: every policy leaves the threads unpinned)" << endl;
+    }
+    for (PlacementPolicy policy : {PlacementPolicy::NONE, PlacementPolicy::COMPACT, PlacementPolicy::SPREAD,
+                                   PlacementPolicy::ISOLATE}) {
+        g_placement.configure(policy, topology, chefs, intake);
+        auto [throughput, latencies] = runPlacedKitchen(chefs, intake, orders, window, work);
+        sort(latencies.begin(), latencies.end());
+        auto percentile = [&](double p) {
+            size_t rank = min(latencies.size() - 1, static_cast<size_t>(p * latencies.size()));
+            return latencies.empty() ? 0.0 : latencies[rank];
+        };
+        string name(placementPolicyToString(policy));
+        cout << "  " << name << endl;
+        printResult("  throughput", throughput / 1e3, "K orders/s");
+        printResult("  order to delivered p50", percentile(0.50), "us");
+        printResult("  order to delivered p99", percentile(0.99), "us");
+        printResult("  order to delivered p99.9", percentile(0.999), "us");
+    }
+    g_placement.configure(PlacementPolicy::NONE, topology, 0, 0);
+}
+
+struct BenchEntry {
+    const char* name;
+    const char* description;
+    void (*run)(const BenchOptions&);
+};
+
+static const BenchEntry BENCHMARKS[] = {
+    {"catalog", "menu load, recipe checks and reservations (--items --ingredients --ops --threads)", benchCatalog},
+    {"availability", "makeable-now scans, SIMD vs scalar (--items --ingredients --queue --rounds)", benchAvailability},
+    {"tracing", "span recording cost and order-path overhead (--orders --spans --days)", benchTracing},
+    {"history", "order-history appends and grouped aggregates (--orders --threads --resident)", benchHistory},
+    {"index", "order-status lookups under concurrent updates (--readers --writers --orders --seconds)", benchIndex},
+    {"messages", "status-line formatting cost and heap allocations (--rounds)", benchMessages},
+    {"snapshot", "checkpoint pause, write and warm-restore time (--max-orders)", benchSnapshot},
+    {"cancel", "order cancellation vs backlog, under concurrent intake and at closing (--backlog --cancels"
+     " --threads --orders --rate)",
+     benchCancel},
+    {"estimate", "queueing-model estimate cost vs a simulated day (--rounds)", benchEstimate},
+    {"placement", "kitchen throughput and tail latency per thread placement policy (--orders --chefs --intake"
+     " --window --work-us)", benchPlacement},
+};
+
+int main(int argc, char** argv) {
+    if (argc < 2 || string(argv[1]) == "list") {
+        cout << "Usage: " << argv[0] << " <benchmark|all> [--key value ...]\n\nBenchmarks:" << endl;
+        for (const auto& entry : BENCHMARKS) {
+            cout << "  " << left << setw(14) << entry.name << entry.description << endl;
+        }
+        return argc < 2 ? 1 : 0;
+    }
+
+    BenchOptions options;
+    for (int i = 2; i + 1 < argc; i += 2) {
+        string key = argv[i];
+        if (key.rfind("--", 0) != 0) {
+            cerr << "Unexpected argument: " << key << endl;
+            return 1;
+        }
+        options[key.substr(2)] = argv[i + 1];
+    }
+
+    string requested = argv[1];
+    bool found = false;
+    try {
+        for (const auto& entry : BENCHMARKS) {
+            if (requested == "all" || requested == entry.name) {
+                entry.run(options);
+                found = true;
+            }
+        }
+    } catch (const exception& e) {
+        cerr << "❌ Error: " << e.what() << endl;
+        return 1;
+    }
+    if (!found) {
+        cerr << "Unknown benchmark: " << requested << endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,260 @@
+#include <bits/stdc++.h>
+#include "catalog.h"
+#include "pizzeria.h"
+using namespace std;
+
+// Active catalog, defaults to the compiled-in menu
+MenuCatalog g_catalog = MenuCatalog::builtin();
+
+static string trim(const string& text) {
+    size_t start = text.find_first_not_of(" \t\r");
+    if (start == string::npos) {
+        return "";
+    }
+    size_t end = text.find_last_not_of(" \t\r");
+    return text.substr(start, end - start + 1);
+}
+
+static vector<string> splitFields(const string& line, char separator) {
+    vector<string> fields;
+    string field;
+    istringstream in(line);
+    while (getline(in, field, separator)) {
+        fields.push_back(trim(field));
+    }
+    return fields;
+}
+
+// MenuCatalog implementation
+MenuCatalog::MenuCatalog() {
+    recipe_offsets.push_back(0);
+}
+
+MenuCatalog MenuCatalog::builtin() {
+    MenuCatalog catalog;
+    for (int i = 0; i < INGREDIENT_TYPE_COUNT; ++i) {
+        catalog.addIngredient(string(INGREDIENT_TABLE[i].name), INGREDIENT_TABLE[i].initial_stock);
+    }
+    for (int i = 0; i < PIZZA_TYPE_COUNT; ++i) {
+        vector<pair<IngredientId, uint16_t>> recipe;
+        for (IngredientMask bits = PIZZA_TABLE[i].recipe; bits; bits &= bits - 1) {
+            recipe.push_back({static_cast<IngredientId>(__builtin_ctz(bits)), 1});
+        }
+        catalog.addItem(string(PIZZA_TABLE[i].name), PIZZA_TABLE[i].price, recipe);
+    }
+    return catalog;
+}
+
+MenuCatalog MenuCatalog::loadFromFile(const string& path) {
+    ifstream in(path);
+    if (!in) {
+        throw runtime_error("Cannot open menu file: " + path);
+    }
+    return loadFromStream(in, path);
+}
+
+MenuCatalog MenuCatalog::loadFromStream(istream& in, const string& source_name) {
+    MenuCatalog catalog;
+    string line;
+    int line_number = 0;
+
+    auto fail = [&](const string& message) {
+        throw runtime_error(source_name + ":" + to_string(line_number) + ": " + message);
+    };
+
+    while (getline(in, line)) {
+        line_number++;
+        size_t comment = line.find('#');
+        if (comment != string::npos) {
+            line.resize(comment);
+        }
+        if (trim(line).empty()) {
+            continue;
+        }
+
+        auto fields = splitFields(line, '|');
+        if (fields[0] == "ingredient") {
+            if (fields.size() != 3 || fields[1].empty()) {
+                fail("expected 'ingredient | <name> | <initial stock>'");
+            }
+            IngredientId existing;
+            if (catalog.findIngredient(fields[1], existing)) {
+                fail("duplicate ingredient '" + fields[1] + "'");
+            }
+            char* end = nullptr;
+            long stock = strtol(fields[2].c_str(), &end, 10);
+            if (*end != '\0' || stock < 0) {
+                fail("invalid stock '" + fields[2] + "'");
+            }
+            if (catalog.getIngredientCount() >= numeric_limits<IngredientId>::max()) {
+                fail("too many ingredients");
+            }
+            catalog.addIngredient(fields[1], static_cast<int>(stock));
+        } else if (fields[0] == "pizza") {
+            if (fields.size() != 4 || fields[1].empty()) {
+                fail("expected 'pizza | <name> | <price> | <ingredient>[:<qty>], ...'");
+            }
+            MenuItemId existing;
+            if (catalog.findItem(fields[1], existing)) {
+                fail("duplicate pizza '" + fields[1] + "'");
+            }
+            char* end = nullptr;
+            double price = strtod(fields[2].c_str(), &end);
+            if (*end != '\0' || price < 0) {
+                fail("invalid price '" + fields[2] + "'");
+            }
+
+            vector<pair<IngredientId, uint16_t>> recipe;
+            for (const auto& entry : splitFields(fields[3], ',')) {
+                string name = entry;
+                long quantity = 1;
+                size_t colon = entry.rfind(':');
+                if (colon != string::npos) {
+                    name = trim(entry.substr(0, colon));
+                    quantity = strtol(entry.c_str() + colon + 1, &end, 10);
+                    if (*end != '\0' || quantity < 1 || quantity > numeric_limits<uint16_t>::max()) {
+                        fail("invalid quantity in '" + entry + "'");
+                    }
+                }
+                IngredientId ingredient;
+                if (!catalog.findIngredient(name, ingredient)) {
+                    fail("unknown ingredient '" + name + "'");
+                }
+                recipe.push_back({ingredient, static_cast<uint16_t>(quantity)});
+            }
+            if (recipe.empty()) {
+                fail("pizza '" + fields[1] + "' has no ingredients");
+            }
+            if (catalog.getItemCount() >= numeric_limits<MenuItemId>::max()) {
+                fail("too many menu items");
+            }
+            catalog.addItem(fields[1], price, recipe);
+        } else {
+            fail("unknown record type '" + fields[0] + "'");
+        }
+    }
+
+    if (catalog.getItemCount() == 0) {
+        throw runtime_error(source_name + ": menu has no pizzas");
+    }
+    return catalog;
+}
+
+IngredientId MenuCatalog::addIngredient(const string& name, int initial_stock) {
+    auto id = static_cast<IngredientId>(ingredient_names.size());
+    ingredient_names.push_back(name);
+    ingredient_initial_stock.push_back(initial_stock);
+    ingredient_lookup[name] = id;
+    return id;
+}
+
+MenuItemId MenuCatalog::addItem(const string& name, double price,
+                                const vector<pair<IngredientId, uint16_t>>& recipe) {
+    auto id = static_cast<MenuItemId>(item_names.size());
+    item_names.push_back(name);
+    item_prices.push_back(price);
+
+    // Merge repeated ingredients and keep each recipe sorted by ingredient ID
+    map<IngredientId, uint32_t> merged;
+    for (const auto& [ingredient, quantity] : recipe) {
+        merged[ingredient] += quantity;
+    }
+    for (const auto& [ingredient, quantity] : merged) {
+        recipe_ingredients.push_back(ingredient);
+        recipe_quantities.push_back(static_cast<uint16_t>(min<uint32_t>(quantity, numeric_limits<uint16_t>::max())));
+    }
+    recipe_offsets.push_back(static_cast<uint32_t>(recipe_ingredients.size()));
+    item_lookup[name] = id;
+    return id;
+}
+
+bool MenuCatalog::findItem(const string& name, MenuItemId& out) const {
+    auto it = item_lookup.find(name);
+    if (it == item_lookup.end()) {
+        return false;
+    }
+    out = it->second;
+    return true;
+}
+
+bool MenuCatalog::findIngredient(const string& name, IngredientId& out) const {
+    auto it = ingredient_lookup.find(name);
+    if (it == ingredient_lookup.end()) {
+        return false;
+    }
+    out = it->second;
+    return true;
+}
+
+// Inventory implementation
+Inventory::Inventory(const MenuCatalog& catalog)
+    : stock(make_unique<atomic<int32_t>[]>(catalog.getIngredientCount())),
+      count(catalog.getIngredientCount()) {
+    for (size_t i = 0; i < count; ++i) {
+        stock[i].store(catalog.getInitialStock(static_cast<IngredientId>(i)), memory_order_relaxed);
+    }
+}
+
+bool Inventory::take(IngredientId ingredient, int32_t amount) {
+    int32_t current = stock[ingredient].load(memory_order_relaxed);
+    while (current >= amount) {
+        if (stock[ingredient].compare_exchange_weak(current, current - amount, memory_order_acq_rel)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool Inventory::canMake(const MenuCatalog& catalog, MenuItemId item) const {
+    const IngredientId* ingredients = catalog.getRecipeIngredients(item);
+    const uint16_t* quantities = catalog.getRecipeQuantities(item);
+    for (size_t i = 0, n = catalog.getRecipeSize(item); i < n; ++i) {
+        if (getQuantity(ingredients[i]) < quantities[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool Inventory::reserve(const MenuCatalog& catalog, MenuItemId item) {
+    const IngredientId* ingredients = catalog.getRecipeIngredients(item);
+    const uint16_t* quantities = catalog.getRecipeQuantities(item);
+    size_t n = catalog.getRecipeSize(item);
+
+    for (size_t i = 0; i < n; ++i) {
+        if (!take(ingredients[i], quantities[i])) {
+            // Roll back what we already took so the reservation is all-or-nothing
+            for (size_t j = 0; j < i; ++j) {
+                restock(ingredients[j], quantities[j]);
+            }
+            return false;
+        }
+    }
+    return true;
+}
+
+void Inventory::release(const MenuCatalog& catalog, MenuItemId item) {
+    const IngredientId* ingredients = catalog.getRecipeIngredients(item);
+    const uint16_t* quantities = catalog.getRecipeQuantities(item);
+    for (size_t i = 0, n = catalog.getRecipeSize(item); i < n; ++i) {
+        restock(ingredients[i], quantities[i]);
+    }
+}
+
+bool Inventory::reserve(const MenuCatalog& catalog, const MenuItemId* items, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        if (!reserve(catalog, items[i])) {
+            // Items sharing an ingredient can fail on the combined quantity;
+            // hand back the recipes already taken
+            release(catalog, items, i);
+            return false;
+        }
+    }
+    return true;
+}
+
+void Inventory::release(const MenuCatalog& catalog, const MenuItemId* items, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        release(catalog, items[i]);
+    }
+}
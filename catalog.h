@@ -0,0 +1,112 @@
+#pragma once
+#include <bits/stdc++.h>
+
+using namespace std;
+
+// Runtime menu catalog with dense IDs.
+//
+// Menu items and ingredients are numbered 0..N-1 at load time and every
+// per-item or per-ingredient attribute lives in a flat array indexed by that
+// ID. Recipes are stored in CSR form: the ingredients of item i are
+// recipe_ingredients[recipe_offsets[i] .. recipe_offsets[i + 1]).
+//
+// Menu file format (one record per line, '#' starts a comment):
+//
+//   ingredient | <name> | <initial stock>
+//   pizza      | <name> | <price> | <ingredient>[:<qty>], <ingredient>[:<qty>], ...
+//
+// Ingredients must be declared before the pizzas that use them.
+
+using MenuItemId = uint16_t;
+using IngredientId = uint16_t;
+
+// Most line items (pizzas) one order can hold
+constexpr size_t MAX_ORDER_ITEMS = 8;
+
+class MenuCatalog {
+private:
+    vector<string> ingredient_names;
+    vector<int> ingredient_initial_stock;
+
+    vector<string> item_names;
+    vector<double> item_prices;
+    vector<uint32_t> recipe_offsets;        // size items + 1
+    vector<IngredientId> recipe_ingredients;
+    vector<uint16_t> recipe_quantities;
+
+    unordered_map<string, IngredientId> ingredient_lookup;
+    unordered_map<string, MenuItemId> item_lookup;
+
+public:
+    MenuCatalog();
+
+    // Catalog built from the compile-time PIZZERIA_MENU/PIZZERIA_INGREDIENTS
+    // tables; item IDs equal PizzaType values.
+    static MenuCatalog builtin();
+
+    // Throws runtime_error naming the file and line on malformed input.
+    static MenuCatalog loadFromFile(const string& path);
+    static MenuCatalog loadFromStream(istream& in, const string& source_name);
+
+    IngredientId addIngredient(const string& name, int initial_stock);
+    MenuItemId addItem(const string& name, double price,
+                       const vector<pair<IngredientId, uint16_t>>& recipe);
+
+    size_t getItemCount() const { return item_names.size(); }
+    size_t getIngredientCount() const { return ingredient_names.size(); }
+
+    string_view getItemName(MenuItemId item) const { return item_names[item]; }
+    double getItemPrice(MenuItemId item) const { return item_prices[item]; }
+    string_view getIngredientName(IngredientId ingredient) const { return ingredient_names[ingredient]; }
+    int getInitialStock(IngredientId ingredient) const { return ingredient_initial_stock[ingredient]; }
+
+    // Recipe of `item` as parallel (ingredient, quantity) spans
+    size_t getRecipeSize(MenuItemId item) const { return recipe_offsets[item + 1] - recipe_offsets[item]; }
+    const IngredientId* getRecipeIngredients(MenuItemId item) const {
+        return recipe_ingredients.data() + recipe_offsets[item];
+    }
+    const uint16_t* getRecipeQuantities(MenuItemId item) const {
+        return recipe_quantities.data() + recipe_offsets[item];
+    }
+
+    bool findItem(const string& name, MenuItemId& out) const;
+    bool findIngredient(const string& name, IngredientId& out) const;
+};
+
+// Ingredient stock as one flat array of atomics indexed by IngredientId.
+// Reservations take a whole recipe or nothing, without locks.
+class Inventory {
+private:
+    unique_ptr<atomic<int32_t>[]> stock;
+    size_t count;
+
+    bool take(IngredientId ingredient, int32_t amount);
+
+public:
+    explicit Inventory(const MenuCatalog& catalog);
+
+    size_t size() const { return count; }
+    int32_t getQuantity(IngredientId ingredient) const {
+        return stock[ingredient].load(memory_order_relaxed);
+    }
+    void restock(IngredientId ingredient, int32_t amount) {
+        stock[ingredient].fetch_add(amount, memory_order_relaxed);
+    }
+
+    // True if every ingredient of `item` is currently in stock
+    bool canMake(const MenuCatalog& catalog, MenuItemId item) const;
+
+    // Atomically consume the whole recipe of `item`, or nothing
+    bool reserve(const MenuCatalog& catalog, MenuItemId item);
+
+    // Return a previously reserved recipe to stock
+    void release(const MenuCatalog& catalog, MenuItemId item);
+
+    // Whole-order versions: every recipe in `items` is consumed, or none
+    bool reserve(const MenuCatalog& catalog, const MenuItemId* items, size_t count);
+    void release(const MenuCatalog& catalog, const MenuItemId* items, size_t count);
+};
+
+// Active catalog, shared by all simulation threads. Replace it (e.g. from a
+// --menu file) before the Pizzeria is created; it must not change afterwards.
+extern MenuCatalog g_catalog;
@@ -0,0 +1,517 @@
+#include <bits/stdc++.h>
+#include "estimator.h"
+#include "pizzeria.h"
+using namespace std;
+
+// Fluid run resolution; within a few percent of a finer step
+static constexpr double FLUID_STEP_S = 0.05;
+
+static double power(double base, int exponent) {
+    double result = 1;
+    for (; exponent > 0; --exponent) {
+        result *= base;
+    }
+    return result;
+}
+
+static double seconds(chrono::nanoseconds duration) {
+    return chrono::duration<double>(duration).count();
+}
+
+// CDF of the sum of `count` independent uniform gaps (Irwin-Hall)
+static double gapSumCdf(int count, double t) {
+    if (count == 0) {
+        return t >= 0 ? 1.0 : 0.0;
+    }
+    double low = ORDER_GAP_MS.low / 1000.0;
+    double width = (ORDER_GAP_MS.high - ORDER_GAP_MS.low) / 1000.0;
+    double x = (t - count * low) / width;
+    if (x <= 0) {
+        return 0.0;
+    }
+    if (x >= count) {
+        return 1.0;
+    }
+    double sum = 0;
+    double binomial = 1;
+    double factorial = 1;
+    for (int i = 1; i <= count; ++i) {
+        factorial *= i;
+    }
+    for (int i = 0; i <= static_cast<int>(x); ++i) {
+        sum += (i % 2 ? -1 : 1) * binomial * power(x - i, count);
+        binomial = binomial * (count - i) / (i + 1);
+    }
+    return sum / factorial;
+}
+
+// Share of customers placing at least `k` orders
+static double atLeastOrders(int k) {
+    if (k <= ORDERS_PER_CUSTOMER.low) {
+        return 1.0;
+    }
+    double width = ORDERS_PER_CUSTOMER.high - ORDERS_PER_CUSTOMER.low + 1;
+    return max(0, ORDERS_PER_CUSTOMER.high - k + 1) / width;
+}
+
+// Orders one customer is expected to have placed by time t
+static double ordersPlacedBy(double t) {
+    double placed = 0;
+    for (int k = 1; k <= ORDERS_PER_CUSTOMER.high; ++k) {
+        placed += atLeastOrders(k) * gapSumCdf(k - 1, t);
+    }
+    return placed;
+}
+
+// Expected time the last of `customers` places their last order
+static double lastCustomerDone(int customers) {
+    double horizon = (ORDERS_PER_CUSTOMER.high - 1) * ORDER_GAP_MS.high / 1000.0;
+    const int steps = 400;
+    double step = horizon / steps;
+    double expected = 0;
+    for (int i = 0; i < steps; ++i) {
+        double t = (i + 0.5) * step;
+        double done = 0; // P(one customer's last order is before t)
+        for (int k = ORDERS_PER_CUSTOMER.low; k <= ORDERS_PER_CUSTOMER.high; ++k) {
+            done += (atLeastOrders(k) - atLeastOrders(k + 1)) * gapSumCdf(k - 1, t);
+        }
+        expected += (1 - power(done, customers)) * step;
+    }
+    return expected;
+}
+
+// Erlang C: probability an arrival waits in M/M/c with offered load `load`
+static double erlangC(int servers, double load) {
+    double blocking = 1;
+    for (int k = 1; k <= servers; ++k) {
+        blocking = load * blocking / (k + load * blocking);
+    }
+    double utilization = load / servers;
+    return blocking / (1 - utilization * (1 - blocking));
+}
+
+static double normalTail(double z) {
+    return 0.5 * erfc(z / sqrt(2.0));
+}
+
+// ShopModel implementation
+ShopModel ShopModel::fromCatalog(const MenuCatalog& catalog, int chefs, int customers) {
+    ShopModel model;
+    model.chefs = chefs;
+    model.customers = customers;
+    for (size_t i = 0; i < catalog.getItemCount(); ++i) {
+        auto item = static_cast<MenuItemId>(i);
+        model.item_prices.push_back(catalog.getItemPrice(item));
+        vector<pair<IngredientId, double>> recipe;
+        for (size_t j = 0; j < catalog.getRecipeSize(item); ++j) {
+            recipe.emplace_back(catalog.getRecipeIngredients(item)[j], catalog.getRecipeQuantities(item)[j]);
+        }
+        model.recipes.push_back(move(recipe));
+    }
+    for (size_t i = 0; i < catalog.getIngredientCount(); ++i) {
+        model.initial_stock.push_back(catalog.getInitialStock(static_cast<IngredientId>(i)));
+    }
+    return model;
+}
+
+ShopEstimate estimateShop(const ShopModel& model) {
+    if (model.chefs < 1 || model.customers < 1 || model.item_prices.empty()) {
+        throw out_of_range("estimator: need at least one chef, customer and menu item");
+    }
+    auto start = chrono::steady_clock::now();
+    ShopEstimate estimate;
+    int chefs = model.chefs;
+    size_t item_types = model.item_prices.size();
+    size_t ingredients = model.initial_stock.size();
+
+    // Service times in seconds. A pizza is prep (base + cook draw / 4) then
+    // cook; the two draws are independent.
+    double pizza_s = (PREP_BASE_MS + COOK_TIME_MS.mean() * 1.25) / 1000;
+    double pizza_var = COOK_TIME_MS.variance() * (1.0 / 16 + 1) / 1e6;
+    double delivery_s = DELIVERY_TIME_MS.mean() / 1000;
+    double delivery_scv = DELIVERY_TIME_MS.variance() / 1e6 / (delivery_s * delivery_s);
+
+    // Pizzas per order: one, or one plus FAMILY_EXTRA_ITEMS for family orders
+    double family = model.family_percent / 100.0;
+    double pizzas = 1 + family * FAMILY_EXTRA_ITEMS.mean();
+    double pizzas_var = family * (FAMILY_EXTRA_ITEMS.variance() + FAMILY_EXTRA_ITEMS.mean() * FAMILY_EXTRA_ITEMS.mean()) -
+                        pow(family * FAMILY_EXTRA_ITEMS.mean(), 2);
+    // Chef rounds a multi-pizza order takes with every chef free
+    double rounds = 1 - family;
+    for (int extra = FAMILY_EXTRA_ITEMS.low; extra <= FAMILY_EXTRA_ITEMS.high; ++extra) {
+        double share = family / (FAMILY_EXTRA_ITEMS.high - FAMILY_EXTRA_ITEMS.low + 1);
+        rounds += share * (model.parallel_prep ? (extra + chefs) / chefs : extra + 1);
+    }
+    double order_duration_s = rounds * pizza_s;
+
+    double mean_price = 0;
+    for (double price : model.item_prices) {
+        mean_price += price / item_types;
+    }
+    double order_price = pizzas * mean_price;
+
+    // Arrivals
+    estimate.expected_orders = model.customers * ORDERS_PER_CUSTOMER.mean();
+    estimate.expected_pizzas = estimate.expected_orders * pizzas;
+    estimate.intake_s = min(seconds(INTAKE_WINDOW), lastCustomerDone(model.customers));
+    estimate.deadline_s = estimate.intake_s + seconds(DRAIN_BUDGET);
+    double arrival_rate = estimate.expected_orders / max(estimate.intake_s, pizza_s);
+    estimate.arrival_rate = arrival_rate;
+    estimate.capacity = chefs / (pizzas * pizza_s);
+
+    // Restocks add RESTOCK_AMOUNT of everything per interval while stock is low
+    double restock_rate = RESTOCK_AMOUNT.mean() / seconds(RESTOCK_INTERVAL);
+    vector<double> use_per_order(ingredients, 0.0);
+    for (const auto& recipe : model.recipes) {
+        for (auto [ingredient, quantity] : recipe) {
+            use_per_order[ingredient] += pizzas * quantity / item_types;
+        }
+    }
+    estimate.ingredient_limit = numeric_limits<double>::infinity();
+    for (double use : use_per_order) {
+        if (use > 0) {
+            estimate.ingredient_limit = min(estimate.ingredient_limit, restock_rate / use);
+        }
+    }
+
+    // Stationary kitchen: jobs are pizzas with parallel prep, whole orders
+    // with serial prep (Allen-Cunneen, Poisson arrivals)
+    double job_rate = model.parallel_prep ? arrival_rate * pizzas : arrival_rate;
+    double job_s = model.parallel_prep ? pizza_s : pizzas * pizza_s;
+    double job_var = model.parallel_prep ? pizza_var : pizzas * pizza_var + pizzas_var * pizza_s * pizza_s;
+    double job_scv = job_var / (job_s * job_s);
+    double kitchen_load = job_rate * job_s;
+    estimate.kitchen.offered_load = kitchen_load / chefs;
+    double kitchen_wait = 0;
+    if (estimate.kitchen.offered_load < 1) {
+        estimate.kitchen.wait_probability = erlangC(chefs, kitchen_load);
+        kitchen_wait = estimate.kitchen.wait_probability * job_s / (chefs - kitchen_load) * (1 + job_scv) / 2;
+    } else {
+        estimate.kitchen.wait_probability = 1;
+    }
+
+    // Stationary driver fed by the kitchen's departures (Whitt's linking
+    // equation for their variability, then Kingman)
+    double kitchen_utilization = min(estimate.kitchen.offered_load, 1.0);
+    double departure_scv = 1 + kitchen_utilization * kitchen_utilization * (job_scv - 1) / sqrt(chefs);
+    double delivery_rate = min({arrival_rate, estimate.capacity, estimate.ingredient_limit});
+    double delivery_utilization = delivery_rate * delivery_s;
+    estimate.delivery.offered_load = delivery_utilization;
+    double delivery_wait = 0;
+    if (delivery_utilization < 1) {
+        estimate.delivery.wait_probability = delivery_utilization;
+        delivery_wait = delivery_utilization / (1 - delivery_utilization) * delivery_s *
+                        (departure_scv + delivery_scv) / 2;
+    } else {
+        estimate.delivery.wait_probability = 1;
+    }
+
+    // Fluid run of the day on a FLUID_STEP_S grid, past the deadline until the
+    // last order is out (or twice the deadline). Pizzas
+    // queue per menu item and start when a chef is free and the recipe is in
+    // stock; a started pizza finishes pizza_s later, spread uniformly with
+    // the cook-time variance. Finished orders go to the driver the same way.
+    size_t deadline_step = static_cast<size_t>(ceil(estimate.deadline_s / FLUID_STEP_S));
+    size_t steps = 2 * deadline_step;
+    auto spread = [](double mean_s, double variance) {
+        double half = sqrt(3 * variance); // uniform with the same variance
+        size_t first = max<size_t>(1, static_cast<size_t>(lround((mean_s - half) / FLUID_STEP_S)));
+        size_t last = max(first + 1, static_cast<size_t>(lround((mean_s + half) / FLUID_STEP_S)));
+        return pair(first, last);
+    };
+    auto [cook_first, cook_last] = spread(pizza_s, pizza_var);
+    auto [drive_first, drive_last] = spread(delivery_s, DELIVERY_TIME_MS.variance() / 1e6);
+    // Completion rates change by these amounts at each step
+    vector<double> cooking_changes(steps + cook_last, 0.0);
+    vector<double> driving_changes(steps + drive_last, 0.0);
+    // Cumulative pizzas placed and started; orders placed, ready, picked up
+    // and delivered
+    vector<double> placed(steps), started(steps);
+    vector<double> ordered(steps), readied(steps), picked_up(steps), delivered_by(steps);
+    vector<double> queued(item_types, 0.0);
+    vector<double> stock(model.initial_stock);
+    vector<double> starting(item_types);
+    vector<double> demand(ingredients);
+    double waiting = 0, busy = 0, cooking_rate = 0, total_started = 0;
+    double ready = 0, total_ready = 0;
+    double driving = 0, driving_rate = 0, total_picked_up = 0, delivered = 0;
+    double next_restock = seconds(RESTOCK_INTERVAL);
+    double arrivals_end_s = (ORDERS_PER_CUSTOMER.high - 1) * ORDER_GAP_MS.high / 1000.0;
+    size_t last_step = steps - 1;
+    estimate.last_delivery_s = steps * FLUID_STEP_S;
+    for (size_t k = 0; k < steps; ++k) {
+        double t = k * FLUID_STEP_S;
+        placed[k] = t <= arrivals_end_s ? model.customers * ordersPlacedBy(t) * pizzas : estimate.expected_pizzas;
+        double arrived = placed[k] - (k > 0 ? placed[k - 1] : 0.0);
+        for (double& pizzas_waiting : queued) {
+            pizzas_waiting += arrived / item_types;
+        }
+        waiting += arrived;
+
+        if (t >= next_restock) {
+            next_restock += seconds(RESTOCK_INTERVAL);
+            if (any_of(stock.begin(), stock.end(), [](double units) { return units < RESTOCK_THRESHOLD; })) {
+                for (double& units : stock) {
+                    units += RESTOCK_AMOUNT.mean();
+                }
+            }
+        }
+
+        cooking_rate += cooking_changes[k];
+        double finished = min(busy, cooking_rate);
+        busy -= finished;
+        ready += finished / pizzas;
+        total_ready += finished / pizzas;
+
+        // Free chefs take makeable pizzas in proportion to what is waiting
+        double now_started = 0;
+        if (waiting > 0 && busy < chefs) {
+            double wanted = 0;
+            for (size_t i = 0; i < item_types; ++i) {
+                double makeable = queued[i];
+                for (auto [ingredient, quantity] : model.recipes[i]) {
+                    makeable = min(makeable, stock[ingredient] / quantity);
+                }
+                starting[i] = makeable;
+                wanted += makeable;
+            }
+            double scale = wanted > chefs - busy ? max(0.0, chefs - busy) / wanted : 1.0;
+            fill(demand.begin(), demand.end(), 0.0);
+            for (size_t i = 0; i < item_types; ++i) {
+                for (auto [ingredient, quantity] : model.recipes[i]) {
+                    demand[ingredient] += starting[i] * scale * quantity;
+                }
+            }
+            for (size_t j = 0; j < ingredients; ++j) {
+                if (demand[j] > stock[j]) {
+                    scale *= stock[j] / demand[j];
+                }
+            }
+            for (size_t i = 0; i < item_types; ++i) {
+                double amount = starting[i] * scale;
+                queued[i] -= amount;
+                now_started += amount;
+                for (auto [ingredient, quantity] : model.recipes[i]) {
+                    stock[ingredient] -= amount * quantity;
+                }
+            }
+        }
+        waiting -= now_started;
+        busy += now_started;
+        total_started += now_started;
+        double per_step = now_started / (cook_last - cook_first);
+        cooking_changes[k + cook_first] += per_step;
+        cooking_changes[k + cook_last] -= per_step;
+
+        // The driver takes one order at a time
+        driving_rate += driving_changes[k];
+        double dropped_off = min(driving, driving_rate);
+        driving -= dropped_off;
+        delivered += dropped_off;
+        double pickup = min(ready, 1 - driving);
+        ready -= pickup;
+        driving += pickup;
+        total_picked_up += pickup;
+        per_step = pickup / (drive_last - drive_first);
+        driving_changes[k + drive_first] += per_step;
+        driving_changes[k + drive_last] -= per_step;
+
+        started[k] = total_started;
+        ordered[k] = placed[k] / pizzas;
+        readied[k] = total_ready;
+        picked_up[k] = total_picked_up;
+        delivered_by[k] = delivered;
+        // Orders still queued or on the ready shelf at the deadline are
+        // refunded; those being cooked or driven are not. Once everything is
+        // delivered and nobody is left to order, the rest of the day is idle.
+        bool idle = delivered >= estimate.expected_orders - 0.5 && t > arrivals_end_s;
+        if (k == deadline_step || (idle && k < deadline_step)) {
+            estimate.expected_refunds = max(0.0, waiting / pizzas + ready);
+        }
+        if (delivered >= estimate.expected_orders - 0.5) {
+            estimate.last_delivery_s = min(estimate.last_delivery_s, t);
+        }
+        if (idle) {
+            last_step = k;
+            break;
+        }
+    }
+    estimate.refund_exposure = estimate.expected_refunds * order_price * LATE_REFUND_RATE;
+
+    // Mean FIFO wait of what got through a queue: the unit that brings
+    // `arrived` to x leaves when `left` reaches x. Units still waiting at the
+    // deadline are left out, as the simulation's latency metrics do.
+    size_t end_step = min(deadline_step, last_step);
+    auto fifoWait = [end_step](const vector<double>& arrived, const vector<double>& left) {
+        double total = 0;
+        double served = 0;
+        size_t j = 0;
+        for (size_t k = 0; k <= end_step; ++k) {
+            // Split this step's arrivals by the step in which they leave
+            double low = k > 0 ? arrived[k - 1] : 0.0;
+            while (low < arrived[k]) {
+                while (j <= end_step && left[j] <= low) {
+                    ++j;
+                }
+                if (j > end_step) {
+                    return served > 0 ? total / served : 0.0;
+                }
+                double previous = j > 0 ? left[j - 1] : 0.0;
+                double high = min(arrived[k], left[j]);
+                double middle = (low + high) / 2;
+                double leaves = (j - (left[j] - middle) / (left[j] - previous)) * FLUID_STEP_S;
+                total += (high - low) * max(0.0, leaves - k * FLUID_STEP_S);
+                served += high - low;
+                low = high;
+            }
+        }
+        return served > 0 ? total / served : 0.0;
+    };
+    estimate.kitchen.mean_wait_s = fifoWait(placed, started) + kitchen_wait;
+    estimate.kitchen.mean_time_s = estimate.kitchen.mean_wait_s + order_duration_s;
+    estimate.delivery.mean_wait_s = fifoWait(readied, picked_up) + delivery_wait;
+    estimate.delivery.mean_time_s = estimate.delivery.mean_wait_s + delivery_s;
+    // Over delivered orders only, like ORDER_TO_DELIVERED
+    estimate.mean_order_to_delivered_s = fifoWait(ordered, delivered_by) + kitchen_wait + delivery_wait;
+
+    // The last delivery moves with the total kitchen work of the day
+    double customer_pizzas_var = ORDERS_PER_CUSTOMER.mean() * pizzas_var +
+                                 ORDERS_PER_CUSTOMER.variance() * pizzas * pizzas;
+    double work_var = model.customers * (ORDERS_PER_CUSTOMER.mean() * pizzas * pizza_var +
+                                         customer_pizzas_var * pizza_s * pizza_s);
+    double deviation = sqrt(work_var) / chefs + sqrt(pizza_var + DELIVERY_TIME_MS.variance() / 1e6);
+    estimate.deadline_miss_probability = normalTail((estimate.deadline_s - estimate.last_delivery_s) / deviation);
+
+    estimate.elapsed = chrono::steady_clock::now() - start;
+    return estimate;
+}
+
+void printEstimate(ostream& out, const ShopModel& model, const ShopEstimate& estimate) {
+    auto stage = [&out](const char* name, const StageEstimate& stage) {
+        out << "  " << left << setw(10) << name << right << "load " << setw(5) << stage.offered_load
+            << "  P(wait) " << setw(4) << stage.wait_probability << "  wait " << setw(5) << stage.mean_wait_s
+            << "s  total " << setw(5) << stage.mean_time_s << "s" << endl;
+    };
+    out << "\n" << string(60, '=') << endl;
+    out << "QUEUEING ESTIMATE: " << model.chefs << " chefs, " << model.customers << " customers";
+    if (model.family_percent > 0) {
+        out << ", " << model.family_percent << "% family orders";
+    }
+    out << endl;
+    out << string(60, '=') << endl;
+    out << fixed << setprecision(2);
+    out << "Orders: " << estimate.expected_orders << " (" << estimate.expected_pizzas << " pizzas) over "
+        << estimate.intake_s << "s, " << estimate.arrival_rate << "/s" << endl;
+    out << "Kitchen capacity: " << estimate.capacity << " orders/s; restocks sustain "
+        << estimate.ingredient_limit << "/s" << endl;
+    stage("Kitchen", estimate.kitchen);
+    stage("Delivery", estimate.delivery);
+    out << "Order to door: " << estimate.mean_order_to_delivered_s << "s; last delivery at "
+        << estimate.last_delivery_s << "s, refunds at " << estimate.deadline_s << "s" << endl;
+    out << "Refund exposure: " << estimate.expected_refunds << " orders, $" << estimate.refund_exposure
+        << " (P(miss deadline) " << estimate.deadline_miss_probability << ")" << endl;
+    out << "Estimated in " << chrono::duration<double, micro>(estimate.elapsed).count() << " us" << endl;
+    out << defaultfloat << setprecision(6);
+}
+
+void printStaffingTable(ostream& out, const ShopModel& model, int max_chefs) {
+    out << "\nSTAFFING (" << model.customers << " customers)" << endl;
+    out << setw(6) << "Chefs" << setw(8) << "Load" << setw(10) << "Kitchen" << setw(10) << "Delivery"
+        << setw(10) << "To door" << setw(10) << "Refunds" << setw(10) << "Exposure" << setw(9) << "P(miss)"
+        << setw(8) << "us" << endl;
+    out << fixed << setprecision(2);
+    ShopModel staffed = model;
+    for (int chefs = 1; chefs <= max_chefs; ++chefs) {
+        staffed.chefs = chefs;
+        ShopEstimate estimate = estimateShop(staffed);
+        out << setw(6) << chefs << setw(8) << estimate.kitchen.offered_load << setw(9)
+            << estimate.kitchen.mean_time_s << "s" << setw(9) << estimate.delivery.mean_time_s << "s" << setw(9)
+            << estimate.mean_order_to_delivered_s << "s" << setw(10) << estimate.expected_refunds << setw(3)
+            << "$" << setw(7) << estimate.refund_exposure << setw(9) << estimate.deadline_miss_probability << setw(8)
+            << setprecision(1) << chrono::duration<double, micro>(estimate.elapsed).count() << setprecision(2)
+            << endl;
+    }
+    out << defaultfloat << setprecision(6);
+}
+
+ObservedDay validateEstimate(ostream& out, const ShopModel& model, int runs, uint64_t seed) {
+    ShopEstimate estimate = estimateShop(model);
+    ObservedDay observed;
+    auto histogramSum = [](const MetricsPayload& before, const MetricsPayload& after, MetricHistogram histogram,
+                           double& sum_s, double& count) {
+        const auto& from = before.histograms[static_cast<int>(histogram)];
+        const auto& to = after.histograms[static_cast<int>(histogram)];
+        sum_s += (to.sum_us - from.sum_us) / 1e6;
+        count += to.count - from.count;
+    };
+    double kitchen_sum = 0, kitchen_count = 0;
+    double delivery_sum = 0, delivery_count = 0;
+    double door_sum = 0, door_count = 0;
+
+    auto start = chrono::steady_clock::now();
+    ios console_format(nullptr);
+    console_format.copyfmt(cout);
+    streambuf* console = cout.rdbuf(nullptr); // the runs' own reports are discarded
+    for (int run = 0; run < runs; ++run) {
+        SimRandom::setMasterSeed(seed + run);
+        g_sim_clock.setVirtual(true);
+        MetricsPayload before, after;
+        g_metrics.snapshot(before);
+        g_pizzeria = make_unique<Pizzeria>(model.chefs, model.customers);
+        if (model.family_percent > 0) {
+            g_pizzeria->enableFamilyOrders(model.family_percent);
+        }
+        g_pizzeria->setParallelPrep(model.parallel_prep);
+        g_pizzeria->startOperations();
+        double refund_dollars = g_pizzeria->getTotalRefunds();
+        g_pizzeria.reset();
+        g_metrics.snapshot(after);
+
+        auto counted = [&](MetricCounter counter) {
+            return static_cast<double>(after.counters[static_cast<int>(counter)] -
+                                       before.counters[static_cast<int>(counter)]);
+        };
+        double refunds = counted(MetricCounter::ORDERS_REFUNDED);
+        observed.orders += counted(MetricCounter::ORDERS_PLACED) / runs;
+        observed.refunds += refunds / runs;
+        observed.refund_dollars += refund_dollars / runs;
+        observed.deadline_misses += (refunds > 0 ? 1.0 : 0.0) / runs;
+        histogramSum(before, after, MetricHistogram::ORDER_TO_READY, kitchen_sum, kitchen_count);
+        histogramSum(before, after, MetricHistogram::READY_TO_DELIVERED, delivery_sum, delivery_count);
+        histogramSum(before, after, MetricHistogram::ORDER_TO_DELIVERED, door_sum, door_count);
+    }
+    cout.rdbuf(console);
+    cout.clear();
+    cout.copyfmt(console_format);
+    g_sim_clock.setVirtual(false);
+    observed.elapsed = chrono::steady_clock::now() - start;
+    observed.mean_kitchen_s = kitchen_count > 0 ? kitchen_sum / kitchen_count : 0;
+    observed.mean_delivery_s = delivery_count > 0 ? delivery_sum / delivery_count : 0;
+    observed.mean_order_to_delivered_s = door_count > 0 ? door_sum / door_count : 0;
+
+    printEstimate(out, model, estimate);
+    out << "\nVALIDATION: " << runs << " virtual-time runs, seeds " << seed << ".." << seed + runs - 1 << endl;
+    out << left << setw(22) << "Metric" << right << setw(11) << "Predicted" << setw(11) << "Observed"
+        << setw(9) << "Error" << endl;
+    out << fixed << setprecision(2);
+    auto row = [&out](const char* name, double predicted, double actual) {
+        out << left << setw(22) << name << right << setw(11) << predicted << setw(11) << actual;
+        if (actual != 0) {
+            out << setw(8) << (predicted - actual) / actual * 100 << "%";
+        } else {
+            out << setw(9) << "-";
+        }
+        out << endl;
+    };
+    row("Orders placed", estimate.expected_orders, observed.orders);
+    row("Kitchen time (s)", estimate.kitchen.mean_time_s, observed.mean_kitchen_s);
+    row("Delivery time (s)", estimate.delivery.mean_time_s, observed.mean_delivery_s);
+    row("Order to door (s)", estimate.mean_order_to_delivered_s, observed.mean_order_to_delivered_s);
+    row("Refunded orders", estimate.expected_refunds, observed.refunds);
+    row("Refunds ($)", estimate.refund_exposure, observed.refund_dollars);
+    row("Days with refunds", estimate.deadline_miss_probability, observed.deadline_misses);
+    out << "Estimate: " << setprecision(1) << chrono::duration<double, micro>(estimate.elapsed).count()
+        << " us; simulations: " << chrono::duration<double, milli>(observed.elapsed).count() << " ms" << endl;
+    out << defaultfloat << setprecision(6);
+    return observed;
+}
@@ -0,0 +1,93 @@
+#pragma once
+#include <bits/stdc++.h>
+#include "catalog.h"
+
+using namespace std;
+
+// Analytic what-if model of a simulated day, for sizing staff without
+// running the 75-second simulation.
+//
+// The shop is a tandem queue: a c-server kitchen (one server per chef, one
+// job per pizza) feeding a single delivery driver, with ingredient stock
+// gating the kitchen. Two views are combined:
+//
+//  * Steady state over the intake window: Erlang C for the kitchen and a
+//    GI/G/1 queue for the driver, with Allen-Cunneen / Kingman corrections
+//    for the near-constant service times and Whitt's approximation for the
+//    variability of the kitchen's departures feeding the driver.
+//  * A mean-value (fluid) run of the real timeline: every customer's first
+//    order at opening, later orders spread over the order gaps, restock
+//    checks, intake closing when the last customer is done and the drain
+//    deadline after it. This carries the opening rush and overload, which a
+//    stationary model cannot, and gives the backlog left at the deadline.
+//
+// Waits are the fluid queueing delay plus the stationary delay while the
+// kitchen is below capacity. Cancellations and socket orders are not
+// modelled. Runs in microseconds; validateEstimate() checks it against
+// virtual-time simulation runs.
+
+struct ShopModel {
+    int chefs = 3;
+    int customers = 5;
+    int family_percent = 0;      // --family-orders
+    bool parallel_prep = true;   // --serial-prep makes one chef do a whole order
+
+    // The menu's prices and recipes (items are ordered uniformly) and the
+    // starting stock
+    static ShopModel fromCatalog(const MenuCatalog& catalog, int chefs, int customers);
+
+    vector<double> item_prices;
+    vector<vector<pair<IngredientId, double>>> recipes;
+    vector<double> initial_stock;
+};
+
+struct StageEstimate {
+    double offered_load = 0;     // demand / capacity while orders arrive; >= 1 is overloaded
+    double wait_probability = 0; // stationary; 1 when overloaded
+    double mean_wait_s = 0;      // queueing before service starts
+    double mean_time_s = 0;      // wait + service
+};
+
+struct ShopEstimate {
+    double expected_orders = 0;
+    double expected_pizzas = 0;
+    double intake_s = 0;         // opening -> last customer done (intake stops)
+    double arrival_rate = 0;     // orders/s over the intake window
+    double capacity = 0;         // kitchen orders/s with every chef busy
+    double ingredient_limit = 0; // orders/s that restocking sustains
+    StageEstimate kitchen;       // placed -> ready
+    StageEstimate delivery;      // ready -> delivered
+    double mean_order_to_delivered_s = 0;
+    double last_delivery_s = 0;  // opening -> last order delivered (mean trajectory)
+    double deadline_s = 0;       // opening -> refunds are issued
+    double deadline_miss_probability = 0;
+    double expected_refunds = 0; // orders still undelivered at the deadline
+    double refund_exposure = 0;  // dollars, at LATE_REFUND_RATE
+    chrono::nanoseconds elapsed{0};
+};
+
+// Throws out_of_range if the model has no chefs, customers or menu items
+ShopEstimate estimateShop(const ShopModel& model);
+
+void printEstimate(ostream& out, const ShopModel& model, const ShopEstimate& estimate);
+
+// Staffing table: the same day with 1..max_chefs chefs
+void printStaffingTable(ostream& out, const ShopModel& model, int max_chefs);
+
+// Mean of `runs` virtual-time simulations of the model (seeds seed,
+// seed + 1, ...), as measured by the pizzeria's metrics
+struct ObservedDay {
+    double orders = 0;
+    double mean_kitchen_s = 0;
+    double mean_delivery_s = 0;
+    double mean_order_to_delivered_s = 0;
+    double refunds = 0;
+    double refund_dollars = 0;
+    double deadline_misses = 0;  // fraction of runs that refunded anything
+    chrono::nanoseconds elapsed{0};
+};
+
+// Runs the simulations in-process (replacing g_pizzeria, output discarded),
+// then prints predicted against observed values. Call with no other
+// pizzeria running.
+ObservedDay validateEstimate(ostream& out, const ShopModel& model, int runs, uint64_t seed);
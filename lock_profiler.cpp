@@ -0,0 +1,110 @@
+#include <bits/stdc++.h>
+#include "lock_profiler.h"
+using namespace std;
+
+#if PIZZERIA_LOCK_PROFILING
+
+LockProfiler g_lock_profiler;
+
+// LockHistogram implementation
+void LockHistogram::record(chrono::steady_clock::duration duration) {
+    uint64_t ns = static_cast<uint64_t>(max<int64_t>(0, chrono::duration_cast<chrono::nanoseconds>(duration).count()));
+    int bucket = min(LOCK_HISTOGRAM_BUCKETS - 1, static_cast<int>(bit_width(ns)));
+    buckets[bucket].fetch_add(1, memory_order_relaxed);
+    count.fetch_add(1, memory_order_relaxed);
+    sum_ns.fetch_add(ns, memory_order_relaxed);
+    uint64_t seen = max_ns.load(memory_order_relaxed);
+    while (ns > seen && !max_ns.compare_exchange_weak(seen, ns, memory_order_relaxed)) {
+    }
+}
+
+uint64_t LockHistogram::percentileNs(double percentile) const {
+    uint64_t total = count.load(memory_order_relaxed);
+    if (total == 0) {
+        return 0;
+    }
+    uint64_t target = static_cast<uint64_t>(ceil(total * percentile / 100.0));
+    uint64_t seen = 0;
+    for (int i = 0; i < LOCK_HISTOGRAM_BUCKETS; ++i) {
+        seen += buckets[i].load(memory_order_relaxed);
+        if (seen >= max<uint64_t>(1, target)) {
+            return min(uint64_t{1} << i, max_ns.load(memory_order_relaxed));
+        }
+    }
+    return max_ns.load(memory_order_relaxed);
+}
+
+// LockProfiler implementation
+LockStats& LockProfiler::registerLock(const char* name, LockKind kind) {
+    lock_guard<mutex> lock(registry_mutex);
+    for (auto& entry : stats) {
+        if (entry.kind == kind && entry.name == name) {
+            return entry;
+        }
+    }
+    LockStats& entry = stats.emplace_back();
+    entry.name = name;
+    entry.kind = kind;
+    return entry;
+}
+
+static string formatNs(uint64_t ns) {
+    if (ns == 0) {
+        return "-";
+    }
+    ostringstream out;
+    out << fixed << setprecision(1);
+    if (ns < 1000) {
+        out << setprecision(0) << static_cast<double>(ns) << "ns";
+    } else if (ns < 1000000) {
+        out << ns / 1e3 << "us";
+    } else if (ns < 1000000000) {
+        out << ns / 1e6 << "ms";
+    } else {
+        out << ns / 1e9 << "s";
+    }
+    return out.str();
+}
+
+void LockProfiler::printReport(ostream& out) {
+    lock_guard<mutex> lock(registry_mutex);
+    vector<const LockStats*> mutexes, conditions;
+    for (const auto& entry : stats) {
+        (entry.kind == LockKind::MUTEX ? mutexes : conditions).push_back(&entry);
+    }
+    sort(mutexes.begin(), mutexes.end(), [](const LockStats* a, const LockStats* b) {
+        return a->wait.sum_ns.load() > b->wait.sum_ns.load();
+    });
+
+    out << "\n" << string(50, '=') << endl;
+    out << "LOCK CONTENTION REPORT (wall-clock)" << endl;
+    out << string(50, '=') << endl;
+    out << left << setfill(' ') << setw(20) << "Mutex" << right << setw(10) << "Acquired" << setw(10) << "Contended"
+        << setw(10) << "Wait p50" << setw(10) << "p99" << setw(10) << "total" << setw(10) << "Hold p50"
+        << setw(10) << "p99" << setw(10) << "max" << endl;
+    for (const LockStats* entry : mutexes) {
+        uint64_t acquired = entry->acquisitions.load();
+        uint64_t contended = entry->contended.load();
+        ostringstream rate;
+        rate << fixed << setprecision(1) << (acquired ? 100.0 * contended / acquired : 0.0) << "%";
+        out << left << setw(20) << entry->name << right << setw(10) << acquired << setw(10) << rate.str()
+            << setw(10) << formatNs(entry->wait.percentileNs(50)) << setw(10) << formatNs(entry->wait.percentileNs(99))
+            << setw(10) << formatNs(entry->wait.sum_ns.load()) << setw(10) << formatNs(entry->hold.percentileNs(50))
+            << setw(10) << formatNs(entry->hold.percentileNs(99)) << setw(10) << formatNs(entry->hold.max_ns.load())
+            << endl;
+    }
+
+    if (!conditions.empty()) {
+        out << "\n" << left << setw(20) << "Condition" << right << setw(10) << "Waits" << setw(10) << "Timeouts"
+            << setw(10) << "Notifies" << setw(10) << "Block p50" << setw(10) << "p99" << setw(10) << "max" << endl;
+        for (const LockStats* entry : conditions) {
+            out << left << setw(20) << entry->name << right << setw(10) << entry->acquisitions.load() << setw(10)
+                << entry->contended.load() << setw(10) << entry->notifies.load() << setw(10)
+                << formatNs(entry->wait.percentileNs(50)) << setw(10) << formatNs(entry->wait.percentileNs(99))
+                << setw(10) << formatNs(entry->wait.max_ns.load()) << endl;
+        }
+    }
+    out << "Contended = acquisitions that found the mutex held; wait times cover those only." << endl;
+}
+
+#endif
@@ -0,0 +1,202 @@
+#pragma once
+#include <bits/stdc++.h>
+
+using namespace std;
+
+// Lock-contention profiling for the pizzeria's mutexes and condition variables.
+//
+// ProfiledMutex and ProfiledConditionVariable are constructed with a name;
+// every lock with the same name (all per-order mutexes, say) shares one
+// LockStats entry in g_lock_profiler. A mutex counts acquisitions and how many
+// of them found it already held, with log2 histograms of the time contended
+// acquisitions waited and of how long it was held. A condition variable counts
+// waits, timeouts and notifies, and how long waiters stayed blocked. An
+// uncontended acquisition costs a try_lock and two steady_clock reads.
+//
+// Profiling is compiled in with -DPIZZERIA_LOCK_PROFILING=1. Otherwise both
+// types are std::mutex and std::condition_variable with a constructor that
+// ignores the name, so nothing is left on the lock paths. Lock through
+// ProfiledLock (not unique_lock<ProfiledMutex>) when the lock is handed to a
+// condition variable, so it is unique_lock<mutex> in plain builds.
+
+#ifndef PIZZERIA_LOCK_PROFILING
+#define PIZZERIA_LOCK_PROFILING 0
+#endif
+
+#if PIZZERIA_LOCK_PROFILING
+
+// Bucket i counts durations in [2^(i-1), 2^i) nanoseconds; bucket 0 is < 1ns
+constexpr int LOCK_HISTOGRAM_BUCKETS = 36;
+
+struct LockHistogram {
+    atomic<uint64_t> buckets[LOCK_HISTOGRAM_BUCKETS] = {};
+    atomic<uint64_t> count{0};
+    atomic<uint64_t> sum_ns{0};
+    atomic<uint64_t> max_ns{0};
+
+    void record(chrono::steady_clock::duration duration);
+
+    // Upper bound of the bucket holding the percentile (0-100), capped at max
+    uint64_t percentileNs(double percentile) const;
+};
+
+enum class LockKind {
+    MUTEX,
+    CONDITION
+};
+
+struct alignas(64) LockStats {
+    string name;
+    LockKind kind = LockKind::MUTEX;
+    atomic<uint64_t> acquisitions{0};  // mutex: times locked; condition: waits
+    atomic<uint64_t> contended{0};     // mutex: found held; condition: timed out
+    atomic<uint64_t> notifies{0};      // condition only
+    LockHistogram wait;                // contended acquisitions / blocked waiters
+    LockHistogram hold;                // mutex only
+};
+
+class LockProfiler {
+private:
+    mutex registry_mutex;
+    deque<LockStats> stats;  // deque keeps entries in place as it grows
+
+public:
+    // Returns the entry for `name`, creating it on first use
+    LockStats& registerLock(const char* name, LockKind kind);
+
+    // Per-lock table, mutexes sorted by total time spent waiting
+    void printReport(ostream& out);
+};
+
+// Global profiler shared by every ProfiledMutex / ProfiledConditionVariable
+extern LockProfiler g_lock_profiler;
+
+class ProfiledMutex {
+private:
+    mutex inner;
+    LockStats& stats;
+    chrono::steady_clock::time_point acquired_at;  // written by the holder only
+
+public:
+    explicit ProfiledMutex(const char* name) : stats(g_lock_profiler.registerLock(name, LockKind::MUTEX)) {}
+
+    ProfiledMutex(const ProfiledMutex&) = delete;
+    ProfiledMutex& operator=(const ProfiledMutex&) = delete;
+
+    void lock() {
+        if (inner.try_lock()) {
+            acquired_at = chrono::steady_clock::now();
+        } else {
+            auto start = chrono::steady_clock::now();
+            inner.lock();
+            acquired_at = chrono::steady_clock::now();
+            stats.contended.fetch_add(1, memory_order_relaxed);
+            stats.wait.record(acquired_at - start);
+        }
+        stats.acquisitions.fetch_add(1, memory_order_relaxed);
+    }
+
+    bool try_lock() {
+        if (!inner.try_lock()) {
+            return false;
+        }
+        acquired_at = chrono::steady_clock::now();
+        stats.acquisitions.fetch_add(1, memory_order_relaxed);
+        return true;
+    }
+
+    void unlock() {
+        auto held = chrono::steady_clock::now() - acquired_at;
+        inner.unlock();
+        stats.hold.record(held);
+    }
+};
+
+using ProfiledLock = unique_lock<ProfiledMutex>;
+
+class ProfiledConditionVariable {
+private:
+    condition_variable_any inner;
+    LockStats& stats;
+
+    void recordWait(chrono::steady_clock::time_point start, bool timed_out) {
+        stats.acquisitions.fetch_add(1, memory_order_relaxed);
+        if (timed_out) {
+            stats.contended.fetch_add(1, memory_order_relaxed);
+        }
+        stats.wait.record(chrono::steady_clock::now() - start);
+    }
+
+public:
+    explicit ProfiledConditionVariable(const char* name)
+        : stats(g_lock_profiler.registerLock(name, LockKind::CONDITION)) {}
+
+    void notify_one() {
+        stats.notifies.fetch_add(1, memory_order_relaxed);
+        inner.notify_one();
+    }
+
+    void notify_all() {
+        stats.notifies.fetch_add(1, memory_order_relaxed);
+        inner.notify_all();
+    }
+
+    template <class Lock>
+    void wait(Lock& lock) {
+        auto start = chrono::steady_clock::now();
+        inner.wait(lock);
+        recordWait(start, false);
+    }
+
+    template <class Lock, class Predicate>
+    void wait(Lock& lock, Predicate pred) {
+        while (!pred()) {
+            wait(lock);
+        }
+    }
+
+    template <class Lock, class Clock, class Duration>
+    cv_status wait_until(Lock& lock, const chrono::time_point<Clock, Duration>& deadline) {
+        auto start = chrono::steady_clock::now();
+        cv_status status = inner.wait_until(lock, deadline);
+        recordWait(start, status == cv_status::timeout);
+        return status;
+    }
+
+    template <class Lock, class Clock, class Duration, class Predicate>
+    bool wait_until(Lock& lock, const chrono::time_point<Clock, Duration>& deadline, Predicate pred) {
+        while (!pred()) {
+            if (wait_until(lock, deadline) == cv_status::timeout) {
+                return pred();
+            }
+        }
+        return true;
+    }
+
+    template <class Lock, class Rep, class Period>
+    cv_status wait_for(Lock& lock, const chrono::duration<Rep, Period>& timeout) {
+        return wait_until(lock, chrono::steady_clock::now() + timeout);
+    }
+
+    template <class Lock, class Rep, class Period, class Predicate>
+    bool wait_for(Lock& lock, const chrono::duration<Rep, Period>& timeout, Predicate pred) {
+        return wait_until(lock, chrono::steady_clock::now() + timeout, pred);
+    }
+};
+
+#else
+
+// Profiling compiled out: the standard types, with the name dropped
+class ProfiledMutex : public mutex {
+public:
+    explicit ProfiledMutex(const char*) {}
+};
+
+class ProfiledConditionVariable : public condition_variable {
+public:
+    explicit ProfiledConditionVariable(const char*) {}
+};
+
+using ProfiledLock = unique_lock<mutex>;
+
+#endif
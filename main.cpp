@@ -1,8 +1,68 @@
 #include <bits/stdc++.h>
+#include "estimator.h"
 #include "pizzeria.h"
 using namespace std;
 
-int main() {
+int main(int argc, char** argv) {
+    // Optional command-line settings
+    string listen_spec;
+    string menu_path;
+    string trace_path;
+    optional<uint64_t> seed;
+    bool virtual_time = false;
+    string history_spill_path;
+    bool alloc_report = false;
+    string snapshot_path;
+    string restore_path;
+    int cancel_percent = 0;
+    int family_percent = 0;
+    bool serial_prep = false;
+    bool estimate_only = false;
+    int validation_runs = 0;
+    PlacementPolicy placement = PlacementPolicy::NONE;
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        if (arg == "--listen" && i + 1 < argc) {
+            listen_spec = argv[++i];
+        } else if (arg == "--menu" && i + 1 < argc) {
+            menu_path = argv[++i];
+        } else if (arg == "--trace" && i + 1 < argc) {
+            trace_path = argv[++i];
+        } else if (arg == "--seed" && i + 1 < argc && isdigit(static_cast<unsigned char>(argv[i + 1][0]))) {
+            seed = strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--virtual-time") {
+            virtual_time = true;
+        } else if (arg == "--history-spill" && i + 1 < argc) {
+            history_spill_path = argv[++i];
+        } else if (arg == "--alloc-report") {
+            alloc_report = true;
+        } else if (arg == "--snapshot" && i + 1 < argc) {
+            snapshot_path = argv[++i];
+        } else if (arg == "--restore" && i + 1 < argc) {
+            restore_path = argv[++i];
+        } else if (arg == "--cancel-rate" && i + 1 < argc && isdigit(static_cast<unsigned char>(argv[i + 1][0]))) {
+            cancel_percent = atoi(argv[++i]);
+        } else if (arg == "--family-orders" && i + 1 < argc && isdigit(static_cast<unsigned char>(argv[i + 1][0]))) {
+            family_percent = atoi(argv[++i]);
+        } else if (arg == "--serial-prep") {
+            serial_prep = true;
+        } else if (arg == "--estimate") {
+            estimate_only = true;
+        } else if (arg == "--validate-estimate" && i + 1 < argc && isdigit(static_cast<unsigned char>(argv[i + 1][0]))) {
+            validation_runs = max(1, atoi(argv[++i]));
+        } else if (arg == "--placement" && i + 1 < argc && parsePlacementPolicy(argv[i + 1], placement)) {
+            ++i;
+        } else {
+            cerr << "Usage: " << argv[0] << " [--listen unix:PATH|tcp:PORT] [--menu FILE] [--trace FILE]"
+                 << " [--seed N] [--virtual-time] [--history-spill FILE] [--alloc-report]"
+                 << " [--snapshot FILE] [--restore FILE] [--cancel-rate PCT]"
+                 << " [--family-orders PCT] [--serial-prep] [--estimate] [--validate-estimate RUNS]"
+                 << " [--placement none|compact|spread|isolate]" << endl;
+            return 1;
+        }
+    }
+
+
     cout << "🍕 Concurrent Pizzeria Simulation 🍕" << endl;
     cout << "=====================================" << endl;
     cout << "This simulation demonstrates:" << endl;
@@ -15,6 +75,12 @@ int main() {
     cout << endl;
     
     try {
+        if (!menu_path.empty()) {
+            g_catalog = MenuCatalog::loadFromFile(menu_path);
+            cout << "📋 Loaded menu " << menu_path << ": " << g_catalog.getItemCount() << " pizzas, "
+                 << g_catalog.getIngredientCount() << " ingredients" << endl;
+        }
+
         // Get user input for simulation parameters
         int num_chefs = 3;
         int num_customers = 5;
@@ -32,7 +98,22 @@ int main() {
             num_customers = 5;
             cout << "Using default: 5 customers" << endl;
         }
-        
+
+        // What-if mode: predict the day with the queueing model instead of
+        // running it, or check the model against virtual-time runs
+        if (estimate_only || validation_runs > 0) {
+            ShopModel model = ShopModel::fromCatalog(g_catalog, num_chefs, num_customers);
+            model.family_percent = family_percent;
+            model.parallel_prep = !serial_prep;
+            if (validation_runs > 0) {
+                validateEstimate(cout, model, validation_runs, seed.value_or(1));
+            } else {
+                printEstimate(cout, model, estimateShop(model));
+                printStaffingTable(cout, model, 6);
+            }
+            return 0;
+        }
+
         cout << endl;
         cout << "🚀 Starting pizzeria with " << num_chefs << " chefs and " 
                   << num_customers << " customers..." << endl;
@@ -40,10 +121,80 @@ int main() {
         cout << "⏱️  Total simulation time: ~45 seconds" << endl;
         cout << endl;
         
+        // One master seed drives every actor's random stream; print it so
+        // any run can be repeated
+        if (!seed) {
+            random_device rd;
+            seed = (static_cast<uint64_t>(rd()) << 32) | rd();
+        }
+        SimRandom::setMasterSeed(*seed);
+        g_sim_clock.setVirtual(virtual_time);
+        cout << "🎲 Seed " << *seed << (virtual_time ? " (virtual time)" : "")
+             << " - rerun with --seed " << *seed << " for the same workload" << endl;
+        cout << endl;
+
+        if (placement != PlacementPolicy::NONE) {
+            g_placement.configure(placement, CpuTopology::detect(), num_chefs, num_customers);
+            cout << "🧭 Placement " << placementPolicyToString(placement) << " over "
+                 << g_placement.getTopology().describe() << endl;
+            cout << endl;
+        }
+
         // Create and start pizzeria
         g_pizzeria = make_unique<Pizzeria>(num_chefs, num_customers);
+        if (!listen_spec.empty()) {
+            OrderServerEndpoint endpoint;
+            if (!OrderServerEndpoint::parse(listen_spec, endpoint)) {
+                cerr << "❌ Invalid --listen endpoint: " << listen_spec << endl;
+                return 1;
+            }
+            g_pizzeria->enableOrderServer(endpoint);
+        }
+        if (!history_spill_path.empty()) {
+            // Beyond ~1M orders (16 segments) older history moves to the file
+            g_pizzeria->getHistory().enableSpill(history_spill_path, 16);
+        }
+        if (!restore_path.empty()) {
+            SnapshotStats restored = g_pizzeria->restoreSnapshot(restore_path);
+            cout << "♻️ Restored " << restored.orders << " orders from " << restore_path << " ("
+                 << restored.bytes / 1024 << " KB) in " << fixed << setprecision(2)
+                 << chrono::duration<double, milli>(restored.elapsed).count() << " ms" << endl;
+            cout << defaultfloat << setprecision(6);
+        }
+        if (cancel_percent > 0) {
+            g_pizzeria->enableCancellations(cancel_percent);
+        }
+        if (family_percent > 0) {
+            g_pizzeria->enableFamilyOrders(family_percent);
+        }
+        g_pizzeria->setParallelPrep(!serial_prep);
+        if (!snapshot_path.empty()) {
+            g_pizzeria->enableCheckpoints(snapshot_path, chrono::seconds(5));
+        }
+        if (!trace_path.empty()) {
+            g_tracer.enable();
+        }
         g_pizzeria->startOperations();
+
+        if (!trace_path.empty()) {
+            g_pizzeria.reset(); // joins every thread that records spans
+            if (g_tracer.writeChromeTrace(trace_path)) {
+                cout << "🧭 Trace written to " << trace_path << " (" << g_tracer.getEventCount()
+                     << " spans, " << g_tracer.getDroppedEvents() << " dropped)" << endl;
+            } else {
+                cerr << "❌ Could not write trace file " << trace_path << endl;
+            }
+        }
         
+        if (alloc_report) {
+            g_pizzeria.reset(); // every actor has finished allocating
+            g_alloc_tracker.printReport(cout);
+        }
+#if PIZZERIA_LOCK_PROFILING
+        g_pizzeria.reset(); // joins every thread before the counters are read
+        g_lock_profiler.printReport(cout);
+#endif
+
         cout << endl;
         cout << "✅ Simulation completed successfully!" << endl;
         cout << "Thank you for running the Concurrent Pizzeria Simulation!" << endl;
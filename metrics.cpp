@@ -0,0 +1,232 @@
+#include <bits/stdc++.h>
+#include "metrics.h"
+
+#if defined(__unix__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#define PIZZERIA_HAVE_SHM 1
+#endif
+
+using namespace std;
+
+// Global metrics registry
+MetricsRegistry g_metrics;
+
+// MetricsRegistry implementation
+int MetricsRegistry::bucketFor(uint64_t micros) {
+    if (micros == 0) {
+        return 0;
+    }
+    int bucket = 64 - __builtin_clzll(micros);
+    return min(bucket, METRICS_HISTOGRAM_BUCKETS - 1);
+}
+
+void MetricsRegistry::recordLatency(MetricHistogram histogram, chrono::steady_clock::duration latency) {
+    auto micros = chrono::duration_cast<chrono::microseconds>(latency).count();
+    uint64_t value = micros > 0 ? static_cast<uint64_t>(micros) : 0;
+
+    auto& h = histograms[static_cast<int>(histogram)];
+    h.buckets[bucketFor(value)].fetch_add(1, memory_order_relaxed);
+    h.count.fetch_add(1, memory_order_relaxed);
+    h.sum_us.fetch_add(value, memory_order_relaxed);
+}
+
+void MetricsRegistry::snapshot(MetricsPayload& out) const {
+    for (int i = 0; i < METRIC_COUNTER_COUNT; ++i) {
+        out.counters[i] = counters[i].load(memory_order_relaxed);
+    }
+    for (int i = 0; i < METRIC_GAUGE_COUNT; ++i) {
+        out.gauges[i] = gauges[i].load(memory_order_relaxed);
+    }
+    for (int i = 0; i < METRIC_HISTOGRAM_COUNT; ++i) {
+        for (int b = 0; b < METRICS_HISTOGRAM_BUCKETS; ++b) {
+            out.histograms[i].buckets[b] = histograms[i].buckets[b].load(memory_order_relaxed);
+        }
+        out.histograms[i].count = histograms[i].count.load(memory_order_relaxed);
+        out.histograms[i].sum_us = histograms[i].sum_us.load(memory_order_relaxed);
+    }
+}
+
+// MetricsExporter implementation
+MetricsExporter::MetricsExporter(const MetricsRegistry& reg, const string& name,
+                                 chrono::milliseconds publish_interval)
+    : registry(reg), shm_name(name), interval(publish_interval),
+      region(nullptr), publish_count(0) {}
+
+MetricsExporter::~MetricsExporter() {
+    stop();
+}
+
+bool MetricsExporter::start(function<void()> on_thread_start) {
+#ifdef PIZZERIA_HAVE_SHM
+    if (running) {
+        return true;
+    }
+
+    int fd = shm_open(shm_name.c_str(), O_CREAT | O_RDWR, 0644);
+    if (fd < 0) {
+        return false;
+    }
+    if (ftruncate(fd, sizeof(MetricsShmLayout)) != 0) {
+        close(fd);
+        return false;
+    }
+    void* mapped = mmap(nullptr, sizeof(MetricsShmLayout), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapped == MAP_FAILED) {
+        return false;
+    }
+
+    region = static_cast<MetricsShmLayout*>(mapped);
+    memset(region, 0, sizeof(MetricsShmLayout));
+    region->version = METRICS_LAYOUT_VERSION;
+    region->payload_size = sizeof(MetricsPayload);
+    region->publisher_pid = static_cast<int32_t>(getpid());
+    // Magic goes last so a monitor never attaches to a half-initialised header
+    atomic_ref<uint32_t>(region->magic).store(METRICS_MAGIC, memory_order_release);
+
+    running = true;
+    publisher_thread = thread([this, on_thread_start = move(on_thread_start)] {
+        if (on_thread_start) {
+            on_thread_start();
+        }
+        publishLoop();
+    });
+    return true;
+#else
+    return false;
+#endif
+}
+
+void MetricsExporter::stop() {
+#ifdef PIZZERIA_HAVE_SHM
+    if (running.exchange(false)) {
+        wait_cv.notify_all();
+        if (publisher_thread.joinable()) {
+            publisher_thread.join();
+        }
+    }
+    if (region) {
+        publishOnce(); // final values for monitors still attached
+        munmap(region, sizeof(MetricsShmLayout));
+        shm_unlink(shm_name.c_str());
+        region = nullptr;
+    }
+#endif
+}
+
+void MetricsExporter::publishLoop() {
+    unique_lock<mutex> lock(wait_mutex);
+    while (running) {
+        publishOnce();
+        wait_cv.wait_for(lock, interval, [this] { return !running; });
+    }
+}
+
+void MetricsExporter::publishOnce() {
+    if (!region) {
+        return;
+    }
+
+    MetricsPayload staged;
+    registry.snapshot(staged);
+    staged.publish_time_ns = chrono::duration_cast<chrono::nanoseconds>(
+        chrono::steady_clock::now().time_since_epoch()).count();
+    staged.publish_count = ++publish_count;
+
+    // Seqlock write: odd sequence while the payload is being replaced. The
+    // payload is copied word by word through atomic_ref so concurrent readers
+    // never observe a torn 64-bit value.
+    atomic_ref<uint64_t> sequence(region->sequence);
+    uint64_t seq = sequence.load(memory_order_relaxed);
+    sequence.store(seq + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+
+    const auto* src = reinterpret_cast<const uint64_t*>(&staged);
+    auto* dst = reinterpret_cast<uint64_t*>(&region->payload);
+    for (size_t i = 0; i < sizeof(MetricsPayload) / sizeof(uint64_t); ++i) {
+        atomic_ref<uint64_t>(dst[i]).store(src[i], memory_order_relaxed);
+    }
+
+    sequence.store(seq + 2, memory_order_release);
+}
+
+// Utility functions
+bool readMetricsPayload(const MetricsShmLayout* region, MetricsPayload& out, int max_attempts) {
+    auto* header = const_cast<MetricsShmLayout*>(region);
+    atomic_ref<uint64_t> sequence(header->sequence);
+    auto* src = reinterpret_cast<uint64_t*>(&header->payload);
+    auto* dst = reinterpret_cast<uint64_t*>(&out);
+
+    for (int attempt = 0; attempt < max_attempts; ++attempt) {
+        uint64_t before = sequence.load(memory_order_acquire);
+        if (before & 1) {
+            this_thread::yield();
+            continue;
+        }
+        for (size_t i = 0; i < sizeof(MetricsPayload) / sizeof(uint64_t); ++i) {
+            dst[i] = atomic_ref<uint64_t>(src[i]).load(memory_order_relaxed);
+        }
+        atomic_thread_fence(memory_order_acquire);
+        if (sequence.load(memory_order_relaxed) == before) {
+            return true;
+        }
+    }
+    return false;
+}
+
+double histogramPercentile(const MetricsHistogramData& histogram, double percentile) {
+    if (histogram.count == 0) {
+        return 0.0;
+    }
+    double target = histogram.count * percentile / 100.0;
+    uint64_t seen = 0;
+    for (int b = 0; b < METRICS_HISTOGRAM_BUCKETS; ++b) {
+        if (histogram.buckets[b] == 0) {
+            continue;
+        }
+        if (seen + histogram.buckets[b] >= target) {
+            // Interpolate linearly inside the bucket [2^(b-1), 2^b)
+            double low = b == 0 ? 0.0 : ldexp(1.0, b - 1);
+            double high = ldexp(1.0, b);
+            double fraction = (target - seen) / histogram.buckets[b];
+            return low + (high - low) * fraction;
+        }
+        seen += histogram.buckets[b];
+    }
+    return ldexp(1.0, METRICS_HISTOGRAM_BUCKETS - 1);
+}
+
+string metricCounterToString(MetricCounter counter) {
+    switch (counter) {
+        case MetricCounter::ORDERS_PLACED: return "Orders Placed";
+        case MetricCounter::ORDERS_COMPLETED: return "Orders Completed";
+        case MetricCounter::ORDERS_DELIVERED: return "Orders Delivered";
+        case MetricCounter::ORDERS_REFUNDED: return "Orders Refunded";
+        case MetricCounter::ORDERS_CANCELLED: return "Orders Cancelled";
+        case MetricCounter::INGREDIENT_SHORTAGES: return "Ingredient Shortages";
+        case MetricCounter::RESTOCKS: return "Restocks";
+        default: return "Unknown";
+    }
+}
+
+string metricGaugeToString(MetricGauge gauge) {
+    switch (gauge) {
+        case MetricGauge::ORDER_QUEUE_DEPTH: return "Order Queue";
+        case MetricGauge::READY_QUEUE_DEPTH: return "Ready Queue";
+        case MetricGauge::CHEFS_BUSY: return "Chefs Busy";
+        default: return "Unknown";
+    }
+}
+
+string metricHistogramToString(MetricHistogram histogram) {
+    switch (histogram) {
+        case MetricHistogram::ORDER_TO_READY: return "Order -> Ready";
+        case MetricHistogram::READY_TO_DELIVERED: return "Ready -> Delivered";
+        case MetricHistogram::ORDER_TO_DELIVERED: return "Order -> Delivered";
+        case MetricHistogram::MULTI_ITEM_KITCHEN: return "Multi-item Kitchen";
+        case MetricHistogram::MULTI_ITEM_WORK: return "Multi-item Chef Work";
+        default: return "Unknown";
+    }
+}
@@ -0,0 +1,154 @@
+#pragma once
+#include <bits/stdc++.h>
+
+using namespace std;
+
+// Shared-memory metrics export.
+//
+// The simulation records into a process-local MetricsRegistry using relaxed
+// atomics only (no locks, no syscalls on the hot path). A MetricsExporter
+// thread periodically copies the registry into a POSIX shared-memory region
+// guarded by a seqlock, where the `pizzeria_monitor` tool can read it.
+
+// Bump METRICS_LAYOUT_VERSION whenever MetricsShmLayout changes.
+constexpr uint32_t METRICS_MAGIC = 0x544D5A50; // "PZMT"
+constexpr uint32_t METRICS_LAYOUT_VERSION = 3;
+constexpr const char* METRICS_DEFAULT_SHM_NAME = "/pizzeria_metrics";
+
+// Bucket i counts samples in [2^(i-1), 2^i) microseconds; bucket 0 is < 1us.
+constexpr int METRICS_HISTOGRAM_BUCKETS = 40;
+
+enum class MetricCounter {
+    ORDERS_PLACED,
+    ORDERS_COMPLETED,
+    ORDERS_DELIVERED,
+    ORDERS_REFUNDED,
+    ORDERS_CANCELLED,
+    INGREDIENT_SHORTAGES,
+    RESTOCKS,
+    COUNT
+};
+
+enum class MetricGauge {
+    ORDER_QUEUE_DEPTH,
+    READY_QUEUE_DEPTH,
+    CHEFS_BUSY,
+    COUNT
+};
+
+enum class MetricHistogram {
+    ORDER_TO_READY,      // placed -> chef finished
+    READY_TO_DELIVERED,  // chef finished -> delivered
+    ORDER_TO_DELIVERED,  // placed -> delivered
+    MULTI_ITEM_KITCHEN,  // multi-item order dispatched -> last pizza cooked
+    MULTI_ITEM_WORK,     // chef time those pizzas took, summed (serial cost)
+    COUNT
+};
+
+constexpr int METRIC_COUNTER_COUNT = static_cast<int>(MetricCounter::COUNT);
+constexpr int METRIC_GAUGE_COUNT = static_cast<int>(MetricGauge::COUNT);
+constexpr int METRIC_HISTOGRAM_COUNT = static_cast<int>(MetricHistogram::COUNT);
+
+// Plain-old-data image of the registry as published in shared memory.
+struct MetricsHistogramData {
+    uint64_t buckets[METRICS_HISTOGRAM_BUCKETS];
+    uint64_t count;
+    uint64_t sum_us;
+};
+
+struct MetricsPayload {
+    uint64_t publish_time_ns;   // steady clock of the publisher
+    uint64_t publish_count;
+    uint64_t counters[METRIC_COUNTER_COUNT];
+    int64_t gauges[METRIC_GAUGE_COUNT];
+    MetricsHistogramData histograms[METRIC_HISTOGRAM_COUNT];
+};
+
+// Fixed header followed by the seqlock-protected payload. The sequence is odd
+// while the publisher is writing; readers retry until they see the same even
+// value before and after copying the payload.
+struct MetricsShmLayout {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t payload_size;
+    int32_t publisher_pid;
+    alignas(64) uint64_t sequence;
+    alignas(64) MetricsPayload payload;
+};
+
+// Process-local metrics, written from the simulation threads.
+class MetricsRegistry {
+private:
+    struct alignas(64) Histogram {
+        atomic<uint64_t> buckets[METRICS_HISTOGRAM_BUCKETS] = {};
+        atomic<uint64_t> count{0};
+        atomic<uint64_t> sum_us{0};
+    };
+
+    alignas(64) atomic<uint64_t> counters[METRIC_COUNTER_COUNT] = {};
+    alignas(64) atomic<int64_t> gauges[METRIC_GAUGE_COUNT] = {};
+    Histogram histograms[METRIC_HISTOGRAM_COUNT];
+
+public:
+    void increment(MetricCounter counter, uint64_t amount = 1) {
+        counters[static_cast<int>(counter)].fetch_add(amount, memory_order_relaxed);
+    }
+
+    void setGauge(MetricGauge gauge, int64_t value) {
+        gauges[static_cast<int>(gauge)].store(value, memory_order_relaxed);
+    }
+
+    void addGauge(MetricGauge gauge, int64_t delta) {
+        gauges[static_cast<int>(gauge)].fetch_add(delta, memory_order_relaxed);
+    }
+
+    void recordLatency(MetricHistogram histogram, chrono::steady_clock::duration latency);
+
+    // Copies the current values into `out` (relaxed; individual values may be
+    // a few nanoseconds apart, which is fine for monitoring).
+    void snapshot(MetricsPayload& out) const;
+
+    static int bucketFor(uint64_t micros);
+};
+
+// Maps the shared-memory region and publishes the registry into it.
+class MetricsExporter {
+private:
+    const MetricsRegistry& registry;
+    string shm_name;
+    chrono::milliseconds interval;
+    MetricsShmLayout* region;
+    uint64_t publish_count;
+    atomic<bool> running{false};
+    thread publisher_thread;
+    mutex wait_mutex;
+    condition_variable wait_cv;
+
+    void publishLoop();
+
+public:
+    MetricsExporter(const MetricsRegistry& reg, const string& name = METRICS_DEFAULT_SHM_NAME,
+                    chrono::milliseconds publish_interval = chrono::milliseconds(100));
+    ~MetricsExporter();
+
+    // Returns false (and keeps the simulation running) if shared memory is
+    // unavailable on this platform or the region could not be created.
+    // `on_thread_start` runs first on the publisher thread (e.g. to pin it).
+    bool start(function<void()> on_thread_start = {});
+    void stop();
+    void publishOnce();
+};
+
+// Reader side of the seqlock, shared with the monitor tool. Returns false if
+// a consistent copy could not be taken within `max_attempts` tries.
+bool readMetricsPayload(const MetricsShmLayout* region, MetricsPayload& out, int max_attempts = 1000);
+
+// Approximate percentile (0-100) in microseconds from histogram buckets.
+double histogramPercentile(const MetricsHistogramData& histogram, double percentile);
+
+string metricCounterToString(MetricCounter counter);
+string metricGaugeToString(MetricGauge gauge);
+string metricHistogramToString(MetricHistogram histogram);
+
+// Global metrics registry shared by all simulation threads
+extern MetricsRegistry g_metrics;
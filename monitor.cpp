@@ -0,0 +1,145 @@
+#include <bits/stdc++.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include "metrics.h"
+using namespace std;
+
+// pizzeria_monitor - attaches to a running simulation's shared-memory metrics
+// and prints live throughput, queue depths and latency percentiles.
+//
+//   pizzeria_monitor [--name /pizzeria_metrics] [--interval-ms 250]
+
+static const MetricsShmLayout* attachRegion(const string& name) {
+    int fd = shm_open(name.c_str(), O_RDONLY, 0);
+    if (fd < 0) {
+        return nullptr;
+    }
+    void* mapped = mmap(nullptr, sizeof(MetricsShmLayout), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapped == MAP_FAILED) {
+        return nullptr;
+    }
+    return static_cast<const MetricsShmLayout*>(mapped);
+}
+
+static bool headerValid(const MetricsShmLayout* region) {
+    auto* header = const_cast<MetricsShmLayout*>(region);
+    return atomic_ref<uint32_t>(header->magic).load(memory_order_acquire) == METRICS_MAGIC &&
+           header->version == METRICS_LAYOUT_VERSION &&
+           header->payload_size == sizeof(MetricsPayload);
+}
+
+// Histogram of only the samples recorded between two snapshots
+static MetricsHistogramData histogramDelta(const MetricsHistogramData& now, const MetricsHistogramData& before) {
+    MetricsHistogramData delta{};
+    for (int b = 0; b < METRICS_HISTOGRAM_BUCKETS; ++b) {
+        delta.buckets[b] = now.buckets[b] - before.buckets[b];
+    }
+    delta.count = now.count - before.count;
+    delta.sum_us = now.sum_us - before.sum_us;
+    return delta;
+}
+
+static string formatMicros(double micros) {
+    ostringstream out;
+    if (micros >= 1e6) {
+        out << fixed << setprecision(2) << micros / 1e6 << "s";
+    } else if (micros >= 1e3) {
+        out << fixed << setprecision(1) << micros / 1e3 << "ms";
+    } else {
+        out << fixed << setprecision(0) << micros << "us";
+    }
+    return out.str();
+}
+
+static void printFrame(const MetricsPayload& now, const MetricsPayload& before, int pid) {
+    double elapsed = (now.publish_time_ns - before.publish_time_ns) / 1e9;
+
+    cout << "\033[H\033[2J";
+    cout << "PIZZERIA LIVE METRICS (pid " << pid << ", publish #" << now.publish_count << ")" << endl;
+    cout << string(70, '=') << endl;
+
+    cout << left << setw(24) << "COUNTER" << right << setw(12) << "TOTAL" << setw(14) << "RATE/s" << endl;
+    for (int i = 0; i < METRIC_COUNTER_COUNT; ++i) {
+        double rate = elapsed > 0 ? (now.counters[i] - before.counters[i]) / elapsed : 0.0;
+        cout << left << setw(24) << metricCounterToString(static_cast<MetricCounter>(i))
+             << right << setw(12) << now.counters[i]
+             << setw(14) << fixed << setprecision(2) << rate << endl;
+    }
+
+    cout << "\n" << left << setw(24) << "GAUGE" << right << setw(12) << "VALUE" << endl;
+    for (int i = 0; i < METRIC_GAUGE_COUNT; ++i) {
+        cout << left << setw(24) << metricGaugeToString(static_cast<MetricGauge>(i))
+             << right << setw(12) << now.gauges[i] << endl;
+    }
+
+    cout << "\n" << left << setw(22) << "LATENCY" << right << setw(8) << "WINDOW"
+         << setw(10) << "p50" << setw(10) << "p95" << setw(10) << "p99"
+         << setw(10) << "ALL p99" << endl;
+    for (int i = 0; i < METRIC_HISTOGRAM_COUNT; ++i) {
+        auto window = histogramDelta(now.histograms[i], before.histograms[i]);
+        cout << left << setw(22) << metricHistogramToString(static_cast<MetricHistogram>(i))
+             << right << setw(8) << window.count
+             << setw(10) << formatMicros(histogramPercentile(window, 50))
+             << setw(10) << formatMicros(histogramPercentile(window, 95))
+             << setw(10) << formatMicros(histogramPercentile(window, 99))
+             << setw(10) << formatMicros(histogramPercentile(now.histograms[i], 99)) << endl;
+    }
+    cout << string(70, '=') << endl;
+    cout << flush;
+}
+
+int main(int argc, char** argv) {
+    string name = METRICS_DEFAULT_SHM_NAME;
+    int interval_ms = 250;
+
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        if (arg == "--name" && i + 1 < argc) {
+            name = argv[++i];
+        } else if (arg == "--interval-ms" && i + 1 < argc) {
+            interval_ms = max(10, atoi(argv[++i]));
+        } else {
+            cerr << "Usage: " << argv[0] << " [--name SHM_NAME] [--interval-ms MS]" << endl;
+            return 1;
+        }
+    }
+
+    cout << "Waiting for pizzeria metrics at " << name << "..." << endl;
+    const MetricsShmLayout* region = nullptr;
+    while (!(region = attachRegion(name)) || !headerValid(region)) {
+        if (region) {
+            munmap(const_cast<MetricsShmLayout*>(region), sizeof(MetricsShmLayout));
+            region = nullptr;
+        }
+        this_thread::sleep_for(chrono::milliseconds(200));
+    }
+
+    int pid = region->publisher_pid;
+    MetricsPayload before{}, now{};
+    if (!readMetricsPayload(region, before)) {
+        cerr << "Could not read a consistent metrics snapshot" << endl;
+        return 1;
+    }
+
+    while (true) {
+        this_thread::sleep_for(chrono::milliseconds(interval_ms));
+        if (kill(pid, 0) != 0 && errno == ESRCH) {
+            cout << "Pizzeria (pid " << pid << ") has exited." << endl;
+            break;
+        }
+        if (!readMetricsPayload(region, now)) {
+            continue;
+        }
+        if (now.publish_count == before.publish_count) {
+            continue; // publisher has not produced a new sample yet
+        }
+        printFrame(now, before, pid);
+        before = now;
+    }
+
+    munmap(const_cast<MetricsShmLayout*>(region), sizeof(MetricsShmLayout));
+    return 0;
+}
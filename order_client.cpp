@@ -0,0 +1,244 @@
+#include <bits/stdc++.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "order_protocol.h"
+using namespace std;
+
+// pizzeria_order_client - load generator for the pizzeria order server.
+//
+//   pizzeria_order_client [--connect unix:PATH|tcp:PORT] [--connections N]
+//                         [--orders N] [--pipeline N] [--wait-delivery SECONDS]
+//                         [--menu-items N]
+//
+// Opens N connections, sends `--orders` PLACE_ORDER frames on each with up to
+// `--pipeline` unacknowledged at a time, and reports acknowledgement latency
+// and throughput. With --wait-delivery it keeps listening for status and
+// delivery notifications for the given number of seconds.
+
+struct ClientConnection {
+    int fd = -1;
+    uint32_t sent = 0;
+    uint32_t acked = 0;
+    size_t input_len = 0;
+    char input[4096];
+    vector<chrono::steady_clock::time_point> send_times;
+};
+
+static int connectTo(const OrderServerEndpoint& endpoint) {
+    int fd;
+    if (endpoint.is_unix) {
+        fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        sockaddr_un addr{};
+        addr.sun_family = AF_UNIX;
+        strncpy(addr.sun_path, endpoint.unix_path.c_str(), sizeof(addr.sun_path) - 1);
+        if (fd < 0 || connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+            if (fd >= 0) close(fd);
+            return -1;
+        }
+    } else {
+        fd = socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        addr.sin_port = htons(endpoint.tcp_port);
+        if (fd < 0 || connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+            if (fd >= 0) close(fd);
+            return -1;
+        }
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    }
+    return fd;
+}
+
+static void raiseFileLimit(size_t wanted) {
+    rlimit limit{};
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < wanted) {
+        limit.rlim_cur = min<rlim_t>(wanted, limit.rlim_max);
+        setrlimit(RLIMIT_NOFILE, &limit);
+    }
+}
+
+int main(int argc, char** argv) {
+    OrderServerEndpoint endpoint;
+    int num_connections = 100;
+    uint32_t orders_per_connection = 10;
+    uint32_t pipeline = 4;
+    int wait_delivery_seconds = 0;
+    int menu_items = 5;
+
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        if (arg == "--connect" && i + 1 < argc) {
+            if (!OrderServerEndpoint::parse(argv[++i], endpoint)) {
+                cerr << "Invalid endpoint: " << argv[i] << endl;
+                return 1;
+            }
+        } else if (arg == "--connections" && i + 1 < argc) {
+            num_connections = max(1, atoi(argv[++i]));
+        } else if (arg == "--orders" && i + 1 < argc) {
+            orders_per_connection = max(1, atoi(argv[++i]));
+        } else if (arg == "--pipeline" && i + 1 < argc) {
+            pipeline = max(1, atoi(argv[++i]));
+        } else if (arg == "--wait-delivery" && i + 1 < argc) {
+            wait_delivery_seconds = max(0, atoi(argv[++i]));
+        } else if (arg == "--menu-items" && i + 1 < argc) {
+            menu_items = max(1, atoi(argv[++i]));
+        } else {
+            cerr << "Usage: " << argv[0] << " [--connect unix:PATH|tcp:PORT] [--connections N]"
+                 << " [--orders N] [--pipeline N] [--wait-delivery SECONDS] [--menu-items N]" << endl;
+            return 1;
+        }
+    }
+
+    raiseFileLimit(num_connections + 64);
+
+    int epoll_fd = epoll_create1(0);
+    vector<ClientConnection> connections(num_connections);
+    auto start_time = chrono::steady_clock::now();
+
+    for (int c = 0; c < num_connections; ++c) {
+        connections[c].fd = connectTo(endpoint);
+        if (connections[c].fd < 0) {
+            cerr << "Connection " << c << " to " << endpoint.toString() << " failed: " << strerror(errno) << endl;
+            return 1;
+        }
+        connections[c].send_times.resize(orders_per_connection);
+        epoll_event ev{};
+        ev.events = EPOLLIN;
+        ev.data.u32 = c;
+        epoll_ctl(epoll_fd, EPOLL_CTL_ADD, connections[c].fd, &ev);
+    }
+    auto connected_time = chrono::steady_clock::now();
+
+    mt19937 gen(12345);
+    uniform_int_distribution<> pizza_choice(0, menu_items - 1);
+
+    auto sendWindow = [&](int c) {
+        auto& conn = connections[c];
+        OrderRequestFrame frames[64];
+        int batch = 0;
+        while (conn.sent < orders_per_connection && conn.sent - conn.acked < pipeline && batch < 64) {
+            auto& frame = frames[batch++];
+            frame.type = static_cast<uint8_t>(OrderFrameType::PLACE_ORDER);
+            frame.reserved = 0;
+            frame.menu_item = static_cast<uint16_t>(pizza_choice(gen));
+            frame.reserved2 = 0;
+            frame.customer_id = static_cast<uint16_t>(c + 1);
+            frame.client_tag = conn.sent;
+            conn.send_times[conn.sent] = chrono::steady_clock::now();
+            conn.sent++;
+        }
+        if (batch > 0 && send(conn.fd, frames, batch * sizeof(OrderRequestFrame), MSG_NOSIGNAL) < 0) {
+            cerr << "send failed: " << strerror(errno) << endl;
+        }
+    };
+
+    for (int c = 0; c < num_connections; ++c) {
+        sendWindow(c);
+    }
+
+    uint64_t total_orders = static_cast<uint64_t>(num_connections) * orders_per_connection;
+    uint64_t accepted = 0, rejected = 0, status_events = 0, delivered = 0, refunded = 0;
+    vector<double> ack_latencies_us;
+    ack_latencies_us.reserve(total_orders);
+    chrono::steady_clock::time_point acked_time;
+    auto deadline = chrono::steady_clock::time_point::max();
+
+    epoll_event events[256];
+    while (true) {
+        auto now = chrono::steady_clock::now();
+        if (accepted + rejected == total_orders) {
+            if (deadline == chrono::steady_clock::time_point::max()) {
+                acked_time = now;
+                deadline = now + chrono::seconds(wait_delivery_seconds);
+            }
+            if (now >= deadline || delivered + refunded == accepted) break;
+        }
+
+        int ready = epoll_wait(epoll_fd, events, 256, 100);
+        for (int i = 0; i < ready; ++i) {
+            int c = events[i].data.u32;
+            auto& conn = connections[c];
+            ssize_t n = read(conn.fd, conn.input + conn.input_len, sizeof(conn.input) - conn.input_len);
+            if (n <= 0) {
+                epoll_ctl(epoll_fd, EPOLL_CTL_DEL, conn.fd, nullptr);
+                continue;
+            }
+            conn.input_len += n;
+
+            size_t offset = 0;
+            auto received = chrono::steady_clock::now();
+            while (conn.input_len - offset >= sizeof(OrderEventFrame)) {
+                OrderEventFrame frame;
+                memcpy(&frame, conn.input + offset, sizeof(frame));
+                offset += sizeof(frame);
+
+                switch (static_cast<OrderEventType>(frame.type)) {
+                    case OrderEventType::ACCEPTED:
+                    case OrderEventType::REJECTED:
+                        if (frame.type == static_cast<uint8_t>(OrderEventType::ACCEPTED)) accepted++;
+                        else rejected++;
+                        conn.acked++;
+                        if (frame.client_tag < orders_per_connection) {
+                            ack_latencies_us.push_back(chrono::duration<double, micro>(
+                                received - conn.send_times[frame.client_tag]).count());
+                        }
+                        break;
+                    case OrderEventType::STATUS: status_events++; break;
+                    case OrderEventType::DELIVERED: delivered++; break;
+                    case OrderEventType::REFUNDED: refunded++; break;
+                }
+            }
+            memmove(conn.input, conn.input + offset, conn.input_len - offset);
+            conn.input_len -= offset;
+            sendWindow(c);
+        }
+
+        if (ready == 0 && accepted + rejected < total_orders &&
+            chrono::steady_clock::now() - connected_time > chrono::seconds(30)) {
+            cerr << "Timed out waiting for acknowledgements" << endl;
+            break;
+        }
+    }
+
+    if (acked_time == chrono::steady_clock::time_point{}) {
+        acked_time = chrono::steady_clock::now();
+    }
+    double connect_seconds = chrono::duration<double>(connected_time - start_time).count();
+    double intake_seconds = chrono::duration<double>(acked_time - connected_time).count();
+
+    sort(ack_latencies_us.begin(), ack_latencies_us.end());
+    auto percentile = [&](double p) {
+        if (ack_latencies_us.empty()) return 0.0;
+        size_t index = min(ack_latencies_us.size() - 1, static_cast<size_t>(p / 100.0 * ack_latencies_us.size()));
+        return ack_latencies_us[index];
+    };
+
+    cout << string(50, '=') << endl;
+    cout << "ORDER CLIENT RESULTS (" << endpoint.toString() << ")" << endl;
+    cout << string(50, '=') << endl;
+    cout << "Connections: " << num_connections << " in " << fixed << setprecision(3)
+         << connect_seconds << "s" << endl;
+    cout << "Orders Sent: " << total_orders << " (pipeline " << pipeline << ")" << endl;
+    cout << "Accepted: " << accepted << "  Rejected: " << rejected << endl;
+    cout << "Intake Throughput: " << fixed << setprecision(0)
+         << (intake_seconds > 0 ? (accepted + rejected) / intake_seconds : 0.0) << " orders/s" << endl;
+    cout << "Ack Latency p50/p99/max: " << fixed << setprecision(1) << percentile(50) << " / "
+         << percentile(99) << " / " << (ack_latencies_us.empty() ? 0.0 : ack_latencies_us.back()) << " us" << endl;
+    cout << "Status Events: " << status_events << "  Delivered: " << delivered
+         << "  Refunded: " << refunded << endl;
+    cout << string(50, '=') << endl;
+
+    for (auto& conn : connections) {
+        if (conn.fd >= 0) close(conn.fd);
+    }
+    close(epoll_fd);
+    return 0;
+}
@@ -0,0 +1,251 @@
+#include <bits/stdc++.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include "order_history.h"
+using namespace std;
+
+// HistoryAggregate implementation
+void HistoryAggregate::merge(const HistoryAggregate& other) {
+    orders += other.orders;
+    delivered += other.delivered;
+    refunded += other.refunded;
+    revenue_cents += other.revenue_cents;
+    refunded_cents += other.refunded_cents;
+    ready_ms_sum += other.ready_ms_sum;
+    ready_count += other.ready_count;
+    delivered_ms_sum += other.delivered_ms_sum;
+    delivered_ms_max = max(delivered_ms_max, other.delivered_ms_max);
+}
+
+// OrderHistory implementation
+OrderHistory::OrderHistory(chrono::steady_clock::time_point history_epoch) : epoch(history_epoch) {
+    static_assert(sizeof(Segment) % 4096 == 0, "spill slots must stay page aligned");
+    // The first segment up front, so the first append (on a delivery or
+    // refund path) does not allocate
+    segments.push_back(shared_ptr<Segment>(new Segment));
+}
+
+OrderHistory::~OrderHistory() {
+    segments.clear(); // unmaps spilled segments before the file is closed
+    if (spill_fd >= 0) {
+        close(spill_fd);
+    }
+}
+
+void OrderHistory::enableSpill(const string& path, size_t resident_segments) {
+    int fd = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0600);
+    if (fd < 0) {
+        throw runtime_error("order history: cannot open spill file " + path + ": " + strerror(errno));
+    }
+    // Scratch space only: unlinked right away so it never outlives the process
+    unlink(path.c_str());
+
+    lock_guard<mutex> lock(append_mutex);
+    if (spill_fd >= 0) {
+        close(spill_fd);
+    }
+    spill_fd = fd;
+    max_resident_segments = max<size_t>(1, resident_segments);
+    spilled_segments = 0;
+    next_to_spill = 0;
+    spillOldSegments();
+}
+
+void OrderHistory::spillOldSegments() {
+    if (spill_fd < 0) {
+        return;
+    }
+    // Only sealed segments move; the one being appended to stays resident
+    while (next_to_spill + 1 < segments.size() && segments.size() - next_to_spill > max_resident_segments) {
+        off_t offset = static_cast<off_t>(spilled_segments * sizeof(Segment));
+        if (ftruncate(spill_fd, offset + sizeof(Segment)) != 0) {
+            spill_failures++;
+            return;
+        }
+        void* mapped = mmap(nullptr, sizeof(Segment), PROT_READ | PROT_WRITE, MAP_SHARED, spill_fd, offset);
+        if (mapped == MAP_FAILED) {
+            spill_failures++;
+            return;
+        }
+        memcpy(mapped, segments[next_to_spill].get(), sizeof(Segment));
+        segments[next_to_spill] = shared_ptr<Segment>(static_cast<Segment*>(mapped),
+            [](Segment* segment) { munmap(segment, sizeof(Segment)); });
+        spilled_segments++;
+        next_to_spill++;
+    }
+}
+
+void OrderHistory::append(const HistoryRow& row) {
+    lock_guard<mutex> lock(append_mutex);
+    size_t slot = row_count % SEGMENT_ROWS;
+    if (slot == 0 && row_count > 0) {
+        // Columns are written before row_count covers them, so no zeroing
+        segments.push_back(shared_ptr<Segment>(new Segment));
+        spillOldSegments();
+    }
+    Segment& segment = *segments.back();
+    segment.order_id[slot] = row.order_id;
+    segment.customer_id[slot] = row.customer_id;
+    segment.menu_item[slot] = row.menu_item;
+    segment.placed_ms[slot] = row.placed_ms;
+    segment.ready_delta_ms[slot] = row.ready_delta_ms;
+    segment.delivered_delta_ms[slot] = row.delivered_delta_ms;
+    segment.price_cents[slot] = row.price_cents;
+    segment.flags[slot] = row.flags;
+    max_placed_ms = max(max_placed_ms, row.placed_ms);
+    row_count++;
+}
+
+void OrderHistory::append(uint32_t order_id, uint16_t customer_id, MenuItemId item, uint32_t price_cents,
+                          chrono::steady_clock::time_point placed, chrono::steady_clock::time_point ready,
+                          chrono::steady_clock::time_point delivered, bool refunded) {
+    auto millis = [](chrono::steady_clock::duration duration) {
+        auto ms = chrono::duration_cast<chrono::milliseconds>(duration).count();
+        return static_cast<uint32_t>(clamp<int64_t>(ms, 0, HISTORY_NO_TIME - 1));
+    };
+    auto reached = [&](chrono::steady_clock::time_point stage) {
+        return stage >= placed && stage != chrono::steady_clock::time_point{};
+    };
+
+    HistoryRow row;
+    row.order_id = order_id;
+    row.customer_id = customer_id;
+    row.menu_item = item;
+    row.placed_ms = millis(placed - epoch);
+    row.ready_delta_ms = reached(ready) ? millis(ready - placed) : HISTORY_NO_TIME;
+    row.delivered_delta_ms = reached(delivered) ? millis(delivered - placed) : HISTORY_NO_TIME;
+    row.price_cents = price_cents;
+    row.flags = (reached(delivered) ? HISTORY_FLAG_DELIVERED : 0) | (refunded ? HISTORY_FLAG_REFUNDED : 0);
+    append(row);
+}
+
+size_t OrderHistory::size() const {
+    lock_guard<mutex> lock(append_mutex);
+    return row_count;
+}
+
+size_t OrderHistory::getSpilledSegments() const {
+    lock_guard<mutex> lock(append_mutex);
+    return spilled_segments;
+}
+
+uint64_t OrderHistory::getSpillFailures() const {
+    lock_guard<mutex> lock(append_mutex);
+    return spill_failures;
+}
+
+size_t OrderHistory::getMemoryBytes() const {
+    lock_guard<mutex> lock(append_mutex);
+    return (segments.size() - spilled_segments) * sizeof(Segment);
+}
+
+HistoryRow OrderHistory::getRow(size_t index) const {
+    lock_guard<mutex> lock(append_mutex);
+    if (index >= row_count) {
+        throw out_of_range("order history: row " + to_string(index) + " of " + to_string(row_count));
+    }
+    const Segment& segment = *segments[index / SEGMENT_ROWS];
+    size_t slot = index % SEGMENT_ROWS;
+    return {segment.order_id[slot], segment.customer_id[slot], segment.menu_item[slot], segment.placed_ms[slot],
+            segment.ready_delta_ms[slot], segment.delivered_delta_ms[slot], segment.price_cents[slot],
+            segment.flags[slot]};
+}
+
+// Folds rows [0, rows) of one segment into `groups`, growing it to fit keys
+template <class KeyColumn>
+static void aggregateSegment(const KeyColumn* keys, uint32_t key_divisor, const uint32_t* ready_delta_ms,
+                             const uint32_t* delivered_delta_ms, const uint32_t* price_cents, const uint8_t* flags,
+                             size_t rows, vector<HistoryAggregate>& groups) {
+    for (size_t r = 0; r < rows; ++r) {
+        size_t key = keys[r] / key_divisor;
+        if (key >= groups.size()) {
+            groups.resize(key + 1);
+        }
+        HistoryAggregate& group = groups[key];
+        group.orders++;
+        if (ready_delta_ms[r] != HISTORY_NO_TIME) {
+            group.ready_ms_sum += ready_delta_ms[r];
+            group.ready_count++;
+        }
+        if (flags[r] & HISTORY_FLAG_DELIVERED) {
+            group.delivered++;
+            group.revenue_cents += price_cents[r];
+            group.delivered_ms_sum += delivered_delta_ms[r];
+            group.delivered_ms_max = max(group.delivered_ms_max, delivered_delta_ms[r]);
+        }
+        if (flags[r] & HISTORY_FLAG_REFUNDED) {
+            group.refunded++;
+            group.refunded_cents += price_cents[r];
+        }
+    }
+}
+
+vector<HistoryAggregate> OrderHistory::aggregate(HistoryGroupBy group_by, chrono::milliseconds bucket,
+                                                 unsigned threads) const {
+    // Snapshot under the lock; rows below row_count are never rewritten
+    vector<shared_ptr<Segment>> snapshot;
+    size_t rows;
+    uint32_t newest_placed_ms;
+    {
+        lock_guard<mutex> lock(append_mutex);
+        snapshot = segments;
+        rows = row_count;
+        newest_placed_ms = max_placed_ms;
+    }
+    if (threads == 0) {
+        threads = max(1u, thread::hardware_concurrency());
+    }
+    threads = static_cast<unsigned>(min<size_t>(threads, max<size_t>(1, snapshot.size())));
+    uint32_t bucket_ms = static_cast<uint32_t>(clamp<int64_t>(bucket.count(), 1, UINT32_MAX));
+    if (group_by == HistoryGroupBy::TIME_BUCKET && newest_placed_ms / bucket_ms >= MAX_TIME_BUCKETS) {
+        throw runtime_error("order history: " + to_string(bucket_ms) + " ms buckets over " +
+                            to_string(newest_placed_ms) + " ms would give more than " +
+                            to_string(MAX_TIME_BUCKETS) + " groups");
+    }
+
+    // Workers claim whole segments and aggregate privately
+    atomic<size_t> next_segment{0};
+    vector<vector<HistoryAggregate>> partials(threads);
+    auto worker = [&](unsigned index) {
+        vector<HistoryAggregate>& groups = partials[index];
+        for (size_t s = next_segment++; s < snapshot.size(); s = next_segment++) {
+            const Segment& segment = *snapshot[s];
+            size_t count = min(SEGMENT_ROWS, rows - s * SEGMENT_ROWS);
+            switch (group_by) {
+            case HistoryGroupBy::MENU_ITEM:
+                aggregateSegment(segment.menu_item, 1, segment.ready_delta_ms, segment.delivered_delta_ms,
+                                 segment.price_cents, segment.flags, count, groups);
+                break;
+            case HistoryGroupBy::CUSTOMER:
+                aggregateSegment(segment.customer_id, 1, segment.ready_delta_ms, segment.delivered_delta_ms,
+                                 segment.price_cents, segment.flags, count, groups);
+                break;
+            case HistoryGroupBy::TIME_BUCKET:
+                aggregateSegment(segment.placed_ms, bucket_ms, segment.ready_delta_ms, segment.delivered_delta_ms,
+                                 segment.price_cents, segment.flags, count, groups);
+                break;
+            }
+        }
+    };
+
+    vector<thread> workers;
+    for (unsigned t = 1; t < threads; ++t) {
+        workers.emplace_back(worker, t);
+    }
+    worker(0);
+    for (auto& w : workers) {
+        w.join();
+    }
+
+    vector<HistoryAggregate> result;
+    for (const auto& groups : partials) {
+        if (groups.size() > result.size()) {
+            result.resize(groups.size());
+        }
+        for (size_t key = 0; key < groups.size(); ++key) {
+            result[key].merge(groups[key]);
+        }
+    }
+    return result;
+}
@@ -0,0 +1,129 @@
+#pragma once
+#include <bits/stdc++.h>
+#include "catalog.h"
+
+using namespace std;
+
+// Columnar history of finished orders (delivered or refunded).
+//
+// Rows are stored column by column in fixed-size segments, 25 bytes per
+// order: ids and prices as 32-bit integers, customer and menu item as 16-bit
+// ids, and stage timestamps as millisecond offsets (placed relative to the
+// history's epoch, ready and delivered as deltas from placed). A query reads
+// only the columns it needs, and segments are scanned in parallel, each worker
+// aggregating into private dense arrays that are merged at the end.
+//
+// With a spill file configured, segments beyond the resident limit are moved
+// into a memory-mapped file, oldest first, so the kernel can page them out
+// under memory pressure. Queries read heap and file-backed segments alike.
+
+// Sentinel for a stage the order never reached
+constexpr uint32_t HISTORY_NO_TIME = UINT32_MAX;
+
+constexpr uint8_t HISTORY_FLAG_DELIVERED = 1 << 0;
+constexpr uint8_t HISTORY_FLAG_REFUNDED = 1 << 1;
+
+struct HistoryRow {
+    uint32_t order_id;
+    uint16_t customer_id;
+    MenuItemId menu_item;
+    uint32_t placed_ms;          // since the history epoch
+    uint32_t ready_delta_ms;     // placed -> ready, or HISTORY_NO_TIME
+    uint32_t delivered_delta_ms; // placed -> delivered, or HISTORY_NO_TIME
+    uint32_t price_cents;
+    uint8_t flags;
+};
+
+enum class HistoryGroupBy {
+    MENU_ITEM,
+    CUSTOMER,
+    TIME_BUCKET   // placed_ms / bucket width
+};
+
+struct HistoryAggregate {
+    uint64_t orders = 0;
+    uint64_t delivered = 0;
+    uint64_t refunded = 0;
+    uint64_t revenue_cents = 0;      // delivered orders only
+    uint64_t refunded_cents = 0;     // original price of refunded orders
+    uint64_t ready_ms_sum = 0;       // over orders that reached ready
+    uint64_t ready_count = 0;
+    uint64_t delivered_ms_sum = 0;   // over delivered orders
+    uint32_t delivered_ms_max = 0;
+
+    double averageReadyMs() const { return ready_count ? static_cast<double>(ready_ms_sum) / ready_count : 0.0; }
+    double averageDeliveredMs() const { return delivered ? static_cast<double>(delivered_ms_sum) / delivered : 0.0; }
+    void merge(const HistoryAggregate& other);
+};
+
+class OrderHistory {
+public:
+    static constexpr size_t SEGMENT_ROWS = 1 << 16;
+    // Aggregates are dense per worker, so time buckets are capped like the
+    // 16-bit customer key (1s buckets cover about 18 hours)
+    static constexpr size_t MAX_TIME_BUCKETS = 1 << 16;
+
+private:
+    // Every column is a multiple of the page size, so a segment can be
+    // copied verbatim into a page-aligned slot of the spill file
+    struct Segment {
+        uint32_t order_id[SEGMENT_ROWS];
+        uint32_t placed_ms[SEGMENT_ROWS];
+        uint32_t ready_delta_ms[SEGMENT_ROWS];
+        uint32_t delivered_delta_ms[SEGMENT_ROWS];
+        uint32_t price_cents[SEGMENT_ROWS];
+        uint16_t customer_id[SEGMENT_ROWS];
+        MenuItemId menu_item[SEGMENT_ROWS];
+        uint8_t flags[SEGMENT_ROWS];
+    };
+
+    chrono::steady_clock::time_point epoch;
+
+    mutable mutex append_mutex;
+    vector<shared_ptr<Segment>> segments;  // shared so queries survive a concurrent spill
+    size_t row_count = 0;
+    uint32_t max_placed_ms = 0;
+
+    // Spill file; disabled while spill_fd < 0
+    int spill_fd = -1;
+    size_t max_resident_segments = 0;
+    size_t spilled_segments = 0;
+    size_t next_to_spill = 0;
+    uint64_t spill_failures = 0;
+
+    void spillOldSegments(); // caller holds append_mutex
+
+public:
+    explicit OrderHistory(chrono::steady_clock::time_point history_epoch = chrono::steady_clock::now());
+    ~OrderHistory();
+
+    OrderHistory(const OrderHistory&) = delete;
+    OrderHistory& operator=(const OrderHistory&) = delete;
+
+    // Keep at most `resident_segments` segments on the heap and move older
+    // ones into `path` (created or truncated). Throws runtime_error if the
+    // file cannot be opened.
+    void enableSpill(const string& path, size_t resident_segments);
+
+    void append(const HistoryRow& row);
+
+    // Encodes timestamps relative to the history epoch; unreached stages
+    // are passed as a default-constructed time_point
+    void append(uint32_t order_id, uint16_t customer_id, MenuItemId item, uint32_t price_cents,
+                chrono::steady_clock::time_point placed, chrono::steady_clock::time_point ready,
+                chrono::steady_clock::time_point delivered, bool refunded);
+
+    size_t size() const;
+    size_t getSpilledSegments() const;
+    uint64_t getSpillFailures() const;
+    size_t getMemoryBytes() const; // resident column bytes
+
+    HistoryRow getRow(size_t index) const;
+
+    // One aggregate per group key (menu item id, customer id or time bucket);
+    // keys with no orders stay zero. threads = 0 uses hardware concurrency.
+    // Throws runtime_error if the bucket width would give more than
+    // MAX_TIME_BUCKETS groups.
+    vector<HistoryAggregate> aggregate(HistoryGroupBy group_by, chrono::milliseconds bucket = chrono::seconds(1),
+                                       unsigned threads = 0) const;
+};
@@ -0,0 +1,230 @@
+#include <bits/stdc++.h>
+#include "order_index.h"
+using namespace std;
+
+// Indexes still alive, so a thread exiting after its index was destroyed
+// does not touch freed memory when it gives its reader slot back
+static mutex live_indexes_mutex;
+static unordered_set<uint64_t> live_indexes;
+static atomic<uint64_t> next_instance_id{1};
+
+struct OrderIndex::ReaderRegistration {
+    uint64_t instance = 0;
+    ReaderSlot* slot = nullptr;
+
+    void release() {
+        lock_guard<mutex> lock(live_indexes_mutex);
+        if (slot && live_indexes.count(instance)) {
+            slot->claimed.store(false, memory_order_release);
+        }
+        slot = nullptr;
+        instance = 0;
+    }
+    ~ReaderRegistration() { release(); }
+};
+
+// OrderIndex implementation
+OrderIndex::Table::Table(size_t capacity) : mask(capacity - 1), slots(new atomic<uint64_t>[capacity]) {
+    for (size_t i = 0; i < capacity; ++i) {
+        slots[i].store(0, memory_order_relaxed);
+    }
+}
+
+OrderIndex::OrderIndex() : instance_id(next_instance_id++), current(new Table(MIN_CAPACITY)) {
+    lock_guard<mutex> lock(live_indexes_mutex);
+    live_indexes.insert(instance_id);
+}
+
+OrderIndex::~OrderIndex() {
+    {
+        lock_guard<mutex> lock(live_indexes_mutex);
+        live_indexes.erase(instance_id);
+    }
+    for (auto& [table, epoch] : retired) {
+        delete table;
+    }
+    delete current.load();
+}
+
+OrderIndex::ReaderSlot* OrderIndex::localReader() {
+    thread_local ReaderRegistration registration;
+    if (registration.instance != instance_id) {
+        // First use of this index on this thread: claim a slot once
+        registration.release();
+        registration.instance = instance_id;
+        for (auto& candidate : readers) {
+            bool expected = false;
+            if (candidate.claimed.compare_exchange_strong(expected, true)) {
+                registration.slot = &candidate;
+                break;
+            }
+        }
+    }
+    return registration.slot;
+}
+
+void OrderIndex::insert(uint32_t order_id, uint8_t status) {
+    while (true) {
+        // 0 = done, 1 = table frozen mid-rebuild, 2 = table too full
+        Table* full = nullptr;
+        int outcome = withEpoch([&](Table* table) {
+            for (size_t i = hashId(order_id) & table->mask, probes = 0; probes <= table->mask;
+                 i = (i + 1) & table->mask, ++probes) {
+                uint64_t slot = table->slots[i].load(memory_order_acquire);
+                while (true) {
+                    if (slot & FROZEN) {
+                        return 1;
+                    }
+                    if (slot != 0 && slotId(slot) != order_id) {
+                        break; // someone else's slot; keep probing
+                    }
+                    if (slot == 0 && table->used.load(memory_order_relaxed) * 2 >= table->mask + 1) {
+                        full = table;
+                        return 2;
+                    }
+                    if (table->slots[i].compare_exchange_weak(slot, pack(order_id, status), memory_order_acq_rel)) {
+                        if (slot == 0) {
+                            table->used.fetch_add(1, memory_order_relaxed);
+                        }
+                        if (slot == 0 || slotStatus(slot) == REMOVED) {
+                            live.fetch_add(1, memory_order_relaxed);
+                        }
+                        return 0;
+                    }
+                    // CAS failed: `slot` holds the new value, re-examine it
+                }
+            }
+            full = table;
+            return 2;
+        });
+        if (outcome == 0) {
+            return;
+        }
+        if (outcome == 1) {
+            waitForRebuild();
+        } else {
+            rebuild(full);
+        }
+    }
+}
+
+bool OrderIndex::update(uint32_t order_id, uint8_t status) {
+    while (true) {
+        // 0 = not found, 1 = updated, 2 = table frozen mid-rebuild
+        int outcome = withEpoch([&](Table* table) {
+            for (size_t i = hashId(order_id) & table->mask, probes = 0; probes <= table->mask;
+                 i = (i + 1) & table->mask, ++probes) {
+                uint64_t slot = table->slots[i].load(memory_order_acquire);
+                if (slot & FROZEN) {
+                    return 2;
+                }
+                if (slot == 0) {
+                    return 0;
+                }
+                if (slotId(slot) != order_id) {
+                    continue;
+                }
+                while (true) {
+                    if (slot & FROZEN) {
+                        return 2;
+                    }
+                    if (slotStatus(slot) == REMOVED) {
+                        return 0;
+                    }
+                    if (table->slots[i].compare_exchange_weak(slot, pack(order_id, status), memory_order_acq_rel)) {
+                        if (status == REMOVED) {
+                            live.fetch_sub(1, memory_order_relaxed);
+                        }
+                        return 1;
+                    }
+                }
+            }
+            return 0;
+        });
+        if (outcome != 2) {
+            return outcome == 1;
+        }
+        waitForRebuild();
+    }
+}
+
+bool OrderIndex::remove(uint32_t order_id) {
+    // A tombstone keeps the id so probe chains through it stay intact
+    return update(order_id, REMOVED);
+}
+
+optional<uint8_t> OrderIndex::lookup(uint32_t order_id) {
+    return withEpoch([&](Table* table) -> optional<uint8_t> {
+        for (size_t i = hashId(order_id) & table->mask, probes = 0; probes <= table->mask;
+             i = (i + 1) & table->mask, ++probes) {
+            // Frozen slots still hold the right value, so reads never wait
+            uint64_t slot = table->slots[i].load(memory_order_acquire) & ~FROZEN;
+            if (slot == 0) {
+                return nullopt;
+            }
+            if (slotId(slot) == order_id) {
+                uint8_t status = slotStatus(slot);
+                return status == REMOVED ? nullopt : optional<uint8_t>(status);
+            }
+        }
+        return nullopt;
+    });
+}
+
+void OrderIndex::waitForRebuild() {
+    // The rebuilder holds the mutex until the new table is published
+    lock_guard<mutex> lock(rebuild_mutex);
+}
+
+void OrderIndex::rebuild(Table* full) {
+    lock_guard<mutex> lock(rebuild_mutex);
+    Table* old_table = current.load(memory_order_acquire);
+    if (old_table != full) {
+        return; // another writer already rebuilt it
+    }
+
+    // Size for the live entries at <= 25% load; tombstones are dropped
+    size_t capacity = MIN_CAPACITY;
+    while (capacity < live.load(memory_order_relaxed) * 4) {
+        capacity *= 2;
+    }
+    auto fresh = make_unique<Table>(capacity);
+    size_t copied = 0;
+    for (size_t i = 0; i <= old_table->mask; ++i) {
+        uint64_t slot = old_table->slots[i].fetch_or(FROZEN, memory_order_acq_rel);
+        if (slot == 0 || slotStatus(slot) == REMOVED) {
+            continue;
+        }
+        size_t j = hashId(slotId(slot)) & fresh->mask;
+        while (fresh->slots[j].load(memory_order_relaxed) != 0) {
+            j = (j + 1) & fresh->mask;
+        }
+        fresh->slots[j].store(slot, memory_order_relaxed);
+        copied++;
+    }
+    fresh->used.store(copied, memory_order_relaxed);
+
+    current.store(fresh.release(), memory_order_seq_cst); // see withEpoch()
+    retired.emplace_back(old_table, global_epoch.fetch_add(1, memory_order_acq_rel));
+    rebuilds.fetch_add(1, memory_order_relaxed);
+    reclaim();
+}
+
+void OrderIndex::reclaim() {
+    uint64_t oldest_active = UINT64_MAX;
+    for (const auto& reader : readers) {
+        uint64_t epoch = reader.epoch.load(memory_order_seq_cst);
+        if (epoch != 0) {
+            oldest_active = min(oldest_active, epoch);
+        }
+    }
+    // A reader that entered in epoch > E loaded `current` after the table
+    // retired in epoch E was replaced, so it cannot be holding it
+    auto freeable = [&](const pair<Table*, uint64_t>& entry) { return entry.second < oldest_active; };
+    for (auto& entry : retired) {
+        if (freeable(entry)) {
+            delete entry.first;
+        }
+    }
+    retired.erase(remove_if(retired.begin(), retired.end(), freeable), retired.end());
+}
@@ -0,0 +1,108 @@
+#pragma once
+#include <bits/stdc++.h>
+
+using namespace std;
+
+// Concurrent "where is order #N?" index.
+//
+// An open-addressing hash table whose slots are single 64-bit words packing
+// the order id and its current status, so a lookup is a few plain atomic
+// loads and a status change is one CAS; neither takes a lock. Removed
+// (delivered or refunded) orders leave tombstones that are dropped when the
+// table is rebuilt.
+//
+// Rebuilds (growth or tombstone cleanup) freeze every old slot with a CAS
+// before copying it, so a writer racing with the copy either lands before the
+// freeze and is carried over, or sees the frozen bit and retries on the new
+// table. Old tables are freed with epoch-based reclamation: readers announce
+// the epoch they entered, and a table retired in epoch E is freed once no
+// reader is still inside an epoch <= E.
+class OrderIndex {
+public:
+    // Status byte values are the caller's (OrderStatus); 0xFF marks removal
+    static constexpr uint8_t REMOVED = 0xFF;
+
+private:
+    static constexpr uint64_t FROZEN = 1ULL << 63;
+    static constexpr size_t MIN_CAPACITY = 1024;
+    static constexpr size_t MAX_READERS = 256;
+
+    struct Table {
+        size_t mask;                 // capacity - 1, capacity a power of two
+        atomic<size_t> used{0};      // claimed slots, tombstones included
+        unique_ptr<atomic<uint64_t>[]> slots;
+        explicit Table(size_t capacity);
+    };
+
+    // One announced epoch per reader thread, on its own cache line
+    struct alignas(64) ReaderSlot {
+        atomic<uint64_t> epoch{0};   // 0 = not reading
+        atomic<bool> claimed{false};
+    };
+
+    // Per-thread cache of the slot it claimed; released at thread exit
+    struct ReaderRegistration;
+
+    uint64_t instance_id;            // never reused, unlike addresses
+    atomic<Table*> current;
+    atomic<size_t> live{0};
+    atomic<uint64_t> global_epoch{1};
+    ReaderSlot readers[MAX_READERS];
+
+    mutex rebuild_mutex;             // rebuilds and the retired list
+    vector<pair<Table*, uint64_t>> retired;
+    atomic<uint64_t> rebuilds{0};
+
+    static uint64_t pack(uint32_t order_id, uint8_t status) {
+        return static_cast<uint64_t>(status) << 32 | order_id;
+    }
+    static uint32_t slotId(uint64_t slot) { return static_cast<uint32_t>(slot); }
+    static uint8_t slotStatus(uint64_t slot) { return static_cast<uint8_t>(slot >> 32); }
+    // Order ids are issued sequentially, so the id itself spreads the live
+    // window over consecutive slots without collisions
+    static size_t hashId(uint32_t order_id) { return order_id; }
+
+    ReaderSlot* localReader();       // nullptr if every slot is taken
+    void rebuild(Table* full);      // takes rebuild_mutex
+    void reclaim();                 // caller holds rebuild_mutex
+    void waitForRebuild();
+
+    // Runs `body` inside an epoch so the table it reads cannot be freed.
+    // Threads beyond MAX_READERS fall back to holding rebuild_mutex.
+    template <class Body>
+    auto withEpoch(Body body) {
+        ReaderSlot* reader = localReader();
+        if (!reader) {
+            lock_guard<mutex> lock(rebuild_mutex);
+            return body(current.load(memory_order_acquire));
+        }
+        // Announce, then load `current`, both seq_cst: paired with rebuild()'s
+        // seq_cst publish and reclaim()'s seq_cst scan, either the rebuilder
+        // sees this epoch or this load sees the new table
+        reader->epoch.store(global_epoch.load(memory_order_acquire), memory_order_seq_cst);
+        auto result = body(current.load(memory_order_seq_cst));
+        reader->epoch.store(0, memory_order_release);
+        return result;
+    }
+
+public:
+    OrderIndex();
+    ~OrderIndex();
+
+    OrderIndex(const OrderIndex&) = delete;
+    OrderIndex& operator=(const OrderIndex&) = delete;
+
+    // Adds or overwrites an entry; order ids must be non-zero
+    void insert(uint32_t order_id, uint8_t status);
+
+    // Returns false if the order is not indexed
+    bool update(uint32_t order_id, uint8_t status);
+    bool remove(uint32_t order_id);
+
+    // Status of a live order, if present
+    optional<uint8_t> lookup(uint32_t order_id);
+
+    size_t size() const { return live.load(memory_order_relaxed); }
+    size_t capacity() const { return current.load(memory_order_acquire)->mask + 1; }
+    uint64_t getRebuilds() const { return rebuilds.load(memory_order_relaxed); }
+};
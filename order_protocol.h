@@ -0,0 +1,83 @@
+#pragma once
+#include <bits/stdc++.h>
+
+using namespace std;
+
+// Compact binary order protocol (host byte order; the server is local only).
+//
+// Client -> server: fixed 12-byte OrderRequestFrame per order. Frames may be
+// pipelined freely; each is answered with an ACCEPTED or REJECTED event and,
+// once accepted, followed by status events until DELIVERED or REFUNDED.
+//
+// Server -> client: fixed 16-byte OrderEventFrame.
+
+enum class OrderFrameType : uint8_t {
+    PLACE_ORDER = 1
+};
+
+enum class OrderEventType : uint8_t {
+    ACCEPTED = 1,
+    REJECTED = 2,
+    STATUS = 3,     // `status` holds the new OrderStatus
+    DELIVERED = 4,
+    REFUNDED = 5
+};
+
+enum class OrderRejectReason : uint8_t {
+    NONE = 0,
+    CLOSED = 1,
+    BAD_MENU_ITEM = 2,
+    BAD_FRAME = 3
+};
+
+#pragma pack(push, 1)
+struct OrderRequestFrame {
+    uint8_t type;           // OrderFrameType::PLACE_ORDER
+    uint8_t reserved;
+    uint16_t menu_item;     // MenuItemId in the server's catalog
+    uint16_t customer_id;
+    uint16_t reserved2;
+    uint32_t client_tag;    // echoed back in every event for this order
+};
+
+struct OrderEventFrame {
+    uint8_t type;           // OrderEventType
+    uint8_t status;         // OrderStatus for STATUS, OrderRejectReason for REJECTED
+    uint16_t reserved;
+    uint32_t client_tag;
+    uint32_t order_id;
+    uint32_t price_cents;
+};
+#pragma pack(pop)
+
+static_assert(sizeof(OrderRequestFrame) == 12, "OrderRequestFrame must stay 12 bytes");
+static_assert(sizeof(OrderEventFrame) == 16, "OrderEventFrame must stay 16 bytes");
+
+// Listen endpoint, parsed from "unix:/path/to.sock" or "tcp:PORT" (loopback).
+struct OrderServerEndpoint {
+    bool is_unix = true;
+    string unix_path = "/tmp/pizzeria.sock";
+    uint16_t tcp_port = 0;
+
+    static bool parse(const string& spec, OrderServerEndpoint& out) {
+        if (spec.rfind("unix:", 0) == 0 && spec.size() > 5) {
+            out.is_unix = true;
+            out.unix_path = spec.substr(5);
+            return out.unix_path.size() < 108; // sizeof(sockaddr_un::sun_path)
+        }
+        if (spec.rfind("tcp:", 0) == 0 && spec.size() > 4) {
+            int port = atoi(spec.c_str() + 4);
+            if (port <= 0 || port > 65535) {
+                return false;
+            }
+            out.is_unix = false;
+            out.tcp_port = static_cast<uint16_t>(port);
+            return true;
+        }
+        return false;
+    }
+
+    string toString() const {
+        return is_unix ? "unix:" + unix_path : "tcp:127.0.0.1:" + to_string(tcp_port);
+    }
+};
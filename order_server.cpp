@@ -0,0 +1,451 @@
+#include <bits/stdc++.h>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "order_server.h"
+#include "pizzeria.h"
+#include "placement.h"
+using namespace std;
+
+// Reserved epoll tags for the non-connection descriptors
+static constexpr uint64_t LISTEN_TAG = numeric_limits<uint64_t>::max();
+static constexpr uint64_t WAKE_TAG = numeric_limits<uint64_t>::max() - 1;
+
+static bool setNonBlocking(int fd) {
+    int flags = fcntl(fd, F_GETFL, 0);
+    return flags >= 0 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0;
+}
+
+uint32_t priceToCents(double price) {
+    return static_cast<uint32_t>(llround(price * 100.0));
+}
+
+// OrderServer implementation
+OrderServer::OrderServer(Pizzeria& p, const OrderServerEndpoint& ep, size_t max_conns)
+    : pizzeria(p), endpoint(ep), max_connections(max_conns),
+      listen_fd(-1), epoll_fd(-1), wake_fd(-1),
+      notify_ring(NOTIFY_RING_SIZE), notify_head(0), notify_count(0) {}
+
+OrderServer::~OrderServer() {
+    stop();
+}
+
+uint64_t OrderServer::makeOrigin(uint32_t slot, uint32_t generation) {
+    return (static_cast<uint64_t>(generation) << 32) | slot;
+}
+
+void OrderServer::start() {
+    if (running) {
+        return;
+    }
+
+    // Undoes the setup so far: every descriptor opened and, once bound, the
+    // unix socket file
+    bool bound = false;
+    auto fail = [this, &bound](const string& what) {
+        string reason = strerror(errno);
+        for (int* fd : {&listen_fd, &epoll_fd, &wake_fd}) {
+            if (*fd >= 0) {
+                close(*fd);
+                *fd = -1;
+            }
+        }
+        if (bound && endpoint.is_unix) {
+            unlink(endpoint.unix_path.c_str());
+        }
+        throw runtime_error("order server: " + what + ": " + reason);
+    };
+
+    if (endpoint.is_unix) {
+        listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (listen_fd < 0) {
+            fail("socket() failed");
+        }
+        sockaddr_un addr{};
+        addr.sun_family = AF_UNIX;
+        strncpy(addr.sun_path, endpoint.unix_path.c_str(), sizeof(addr.sun_path) - 1);
+        unlink(endpoint.unix_path.c_str());
+        if (bind(listen_fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+            fail("cannot bind " + endpoint.toString());
+        }
+    } else {
+        listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+        if (listen_fd < 0) {
+            fail("socket() failed");
+        }
+        int one = 1;
+        setsockopt(listen_fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        addr.sin_port = htons(endpoint.tcp_port);
+        if (bind(listen_fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+            fail("cannot bind " + endpoint.toString());
+        }
+    }
+    bound = true;
+
+    if (listen(listen_fd, SOMAXCONN) != 0 || !setNonBlocking(listen_fd)) {
+        fail("listen() failed");
+    }
+
+    epoll_fd = epoll_create1(0);
+    if (epoll_fd < 0) {
+        fail("epoll_create1() failed");
+    }
+    wake_fd = eventfd(0, EFD_NONBLOCK);
+    if (wake_fd < 0) {
+        fail("eventfd() failed");
+    }
+
+    epoll_event ev{};
+    ev.events = EPOLLIN;
+    ev.data.u64 = LISTEN_TAG;
+    epoll_ctl(epoll_fd, EPOLL_CTL_ADD, listen_fd, &ev);
+    ev.data.u64 = WAKE_TAG;
+    epoll_ctl(epoll_fd, EPOLL_CTL_ADD, wake_fd, &ev);
+
+    // Slots are created up front; their buffers on first use
+    connections.resize(max_connections);
+    free_slots.reserve(max_connections);
+    for (size_t i = max_connections; i-- > 0;) {
+        free_slots.push_back(static_cast<uint32_t>(i));
+    }
+
+    running = true;
+    loop_thread = thread([this] {
+        g_placement.pinCurrentThread(WorkerRole::INTAKE, -1);
+        eventLoop();
+    });
+}
+
+void OrderServer::stop() {
+    if (running.exchange(false)) {
+        uint64_t one = 1;
+        ssize_t ignored = write(wake_fd, &one, sizeof(one));
+        (void)ignored;
+        if (loop_thread.joinable()) {
+            loop_thread.join();
+        }
+    }
+
+    for (uint32_t slot = 0; slot < connections.size(); ++slot) {
+        if (connections[slot].fd >= 0) {
+            closeConnection(slot);
+        }
+    }
+    if (listen_fd >= 0) {
+        close(listen_fd);
+        listen_fd = -1;
+        if (endpoint.is_unix) {
+            unlink(endpoint.unix_path.c_str());
+        }
+    }
+    if (wake_fd >= 0) {
+        close(wake_fd);
+        wake_fd = -1;
+    }
+    if (epoll_fd >= 0) {
+        close(epoll_fd);
+        epoll_fd = -1;
+    }
+}
+
+void OrderServer::eventLoop() {
+    epoll_event events[256];
+
+    while (running) {
+        int ready = epoll_wait(epoll_fd, events, 256, 200);
+        if (ready < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+
+        for (int i = 0; i < ready; ++i) {
+            uint64_t tag = events[i].data.u64;
+            if (tag == LISTEN_TAG) {
+                acceptConnections();
+            } else if (tag == WAKE_TAG) {
+                uint64_t counter;
+                ssize_t ignored = read(wake_fd, &counter, sizeof(counter));
+                (void)ignored;
+            } else {
+                uint32_t slot = static_cast<uint32_t>(tag);
+                if (connections[slot].fd < 0) continue;
+                if (events[i].events & (EPOLLHUP | EPOLLERR)) {
+                    closeConnection(slot);
+                    continue;
+                }
+                if (events[i].events & EPOLLIN) handleReadable(slot);
+                if (connections[slot].fd >= 0 && (events[i].events & EPOLLOUT)) handleWritable(slot);
+            }
+        }
+
+        drainNotifications();
+    }
+
+    // Push out anything the kitchen reported during shutdown
+    drainNotifications();
+}
+
+void OrderServer::acceptConnections() {
+    while (true) {
+        int fd = accept4(listen_fd, nullptr, nullptr, SOCK_NONBLOCK);
+        if (fd < 0) {
+            return; // EAGAIN, or a transient error; epoll will report again
+        }
+        if (free_slots.empty()) {
+            close(fd);
+            continue;
+        }
+        if (!endpoint.is_unix) {
+            int one = 1;
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        }
+
+        uint32_t slot = free_slots.back();
+        free_slots.pop_back();
+        auto& conn = connections[slot];
+        if (!conn.input) {
+            conn.input = make_unique<char[]>(INPUT_BUFFER_SIZE);
+            conn.output = make_unique<char[]>(OUTPUT_BUFFER_SIZE);
+        }
+        conn.fd = fd;
+        conn.generation++;
+        conn.input_len = 0;
+        conn.output_head = 0;
+        conn.output_len = 0;
+        conn.want_write = false;
+
+        epoll_event ev{};
+        ev.events = EPOLLIN | EPOLLRDHUP;
+        ev.data.u64 = slot;
+        epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &ev);
+        connections_accepted++;
+    }
+}
+
+void OrderServer::handleReadable(uint32_t slot) {
+    auto& conn = connections[slot];
+    while (conn.fd >= 0) {
+        ssize_t n = read(conn.fd, conn.input.get() + conn.input_len, INPUT_BUFFER_SIZE - conn.input_len);
+        if (n > 0) {
+            conn.input_len += n;
+            processFrames(slot);
+            continue;
+        }
+        if (n == 0 || (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) {
+            closeConnection(slot);
+        }
+        return;
+    }
+}
+
+void OrderServer::processFrames(uint32_t slot) {
+    auto& conn = connections[slot];
+    size_t offset = 0;
+
+    while (conn.fd >= 0 && conn.input_len - offset >= sizeof(OrderRequestFrame)) {
+        OrderRequestFrame request;
+        memcpy(&request, conn.input.get() + offset, sizeof(request));
+        offset += sizeof(request);
+
+        OrderEventFrame reply{};
+        reply.client_tag = request.client_tag;
+
+        if (request.type != static_cast<uint8_t>(OrderFrameType::PLACE_ORDER)) {
+            reply.type = static_cast<uint8_t>(OrderEventType::REJECTED);
+            reply.status = static_cast<uint8_t>(OrderRejectReason::BAD_FRAME);
+            orders_rejected++;
+        } else if (request.menu_item >= g_catalog.getItemCount()) {
+            reply.type = static_cast<uint8_t>(OrderEventType::REJECTED);
+            reply.status = static_cast<uint8_t>(OrderRejectReason::BAD_MENU_ITEM);
+            orders_rejected++;
+        } else if (!pizzeria.isAcceptingOrders()) {
+            reply.type = static_cast<uint8_t>(OrderEventType::REJECTED);
+            reply.status = static_cast<uint8_t>(OrderRejectReason::CLOSED);
+            orders_rejected++;
+        } else {
+            auto order = make_shared<Order>(request.customer_id, request.menu_item);
+            order->setOrigin(makeOrigin(slot, conn.generation), request.client_tag);
+            order->setPaid(true);
+
+            reply.type = static_cast<uint8_t>(OrderEventType::ACCEPTED);
+            reply.order_id = order->getOrderId();
+            reply.price_cents = priceToCents(order->getPrice());
+            // Queue the acknowledgement before the kitchen can report progress
+            if (!queueFrame(slot, reply)) {
+                return;
+            }
+            pizzeria.addOrder(order);
+            orders_accepted++;
+            continue;
+        }
+
+        if (!queueFrame(slot, reply)) {
+            return;
+        }
+    }
+
+    if (conn.fd >= 0) {
+        // Keep any partial frame at the front of the buffer
+        memmove(conn.input.get(), conn.input.get() + offset, conn.input_len - offset);
+        conn.input_len -= offset;
+        flushOutput(slot);
+    }
+}
+
+bool OrderServer::queueFrame(uint32_t slot, const OrderEventFrame& frame) {
+    auto& conn = connections[slot];
+    if (conn.output_head + conn.output_len + sizeof(frame) > OUTPUT_BUFFER_SIZE) {
+        memmove(conn.output.get(), conn.output.get() + conn.output_head, conn.output_len);
+        conn.output_head = 0;
+    }
+    if (conn.output_len + sizeof(frame) > OUTPUT_BUFFER_SIZE) {
+        // The client is not reading its notifications; bound our memory
+        closeConnection(slot);
+        return false;
+    }
+    memcpy(conn.output.get() + conn.output_head + conn.output_len, &frame, sizeof(frame));
+    conn.output_len += sizeof(frame);
+    return true;
+}
+
+bool OrderServer::flushOutput(uint32_t slot) {
+    auto& conn = connections[slot];
+    while (conn.output_len > 0) {
+        ssize_t n = send(conn.fd, conn.output.get() + conn.output_head, conn.output_len, MSG_NOSIGNAL);
+        if (n > 0) {
+            conn.output_head += n;
+            conn.output_len -= n;
+            continue;
+        }
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            break;
+        }
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        closeConnection(slot);
+        return false;
+    }
+    if (conn.output_len == 0) {
+        conn.output_head = 0;
+    }
+    updateInterest(slot);
+    return true;
+}
+
+void OrderServer::handleWritable(uint32_t slot) {
+    flushOutput(slot);
+}
+
+void OrderServer::updateInterest(uint32_t slot) {
+    auto& conn = connections[slot];
+    bool want_write = conn.output_len > 0;
+    if (want_write == conn.want_write) {
+        return;
+    }
+    conn.want_write = want_write;
+    epoll_event ev{};
+    ev.events = EPOLLIN | EPOLLRDHUP | (want_write ? EPOLLOUT : 0u);
+    ev.data.u64 = slot;
+    epoll_ctl(epoll_fd, EPOLL_CTL_MOD, conn.fd, &ev);
+}
+
+void OrderServer::closeConnection(uint32_t slot) {
+    auto& conn = connections[slot];
+    if (conn.fd < 0) {
+        return;
+    }
+    epoll_ctl(epoll_fd, EPOLL_CTL_DEL, conn.fd, nullptr);
+    close(conn.fd);
+    conn.fd = -1;
+    conn.input_len = 0;
+    conn.output_len = 0;
+    conn.output_head = 0;
+    free_slots.push_back(slot);
+}
+
+void OrderServer::notifyOrderEvent(const Order& order, OrderEventType type) {
+    Notification note;
+    note.origin = order.getOrigin();
+    note.frame = OrderEventFrame{};
+    note.frame.type = static_cast<uint8_t>(type);
+    note.frame.status = static_cast<uint8_t>(order.getStatus());
+    note.frame.client_tag = order.getClientTag();
+    note.frame.order_id = order.getOrderId();
+    note.frame.price_cents = priceToCents(order.getPrice());
+
+    {
+        lock_guard<mutex> lock(notify_mutex);
+        if (notify_count == notify_ring.size()) {
+            notifications_dropped++;
+            return;
+        }
+        notify_ring[(notify_head + notify_count) % notify_ring.size()] = note;
+        notify_count++;
+    }
+
+    uint64_t one = 1;
+    ssize_t ignored = write(wake_fd, &one, sizeof(one));
+    (void)ignored;
+}
+
+void OrderServer::drainNotifications() {
+    // Copy out in small batches so kitchen threads never wait on socket I/O
+    Notification batch[256];
+    while (true) {
+        size_t taken = 0;
+        {
+            lock_guard<mutex> lock(notify_mutex);
+            while (taken < 256 && notify_count > 0) {
+                batch[taken++] = notify_ring[notify_head];
+                notify_head = (notify_head + 1) % notify_ring.size();
+                notify_count--;
+            }
+        }
+        if (taken == 0) {
+            return;
+        }
+
+        for (size_t i = 0; i < taken; ++i) {
+            uint32_t slot = static_cast<uint32_t>(batch[i].origin);
+            uint32_t generation = static_cast<uint32_t>(batch[i].origin >> 32);
+            if (slot >= connections.size()) continue;
+            auto& conn = connections[slot];
+            if (conn.fd < 0 || conn.generation != generation) {
+                continue; // the client has gone away
+            }
+            if (queueFrame(slot, batch[i].frame)) {
+                flushOutput(slot);
+            }
+        }
+    }
+}
+
+const OrderServerEndpoint& OrderServer::getEndpoint() const {
+    return endpoint;
+}
+
+uint64_t OrderServer::getConnectionsAccepted() const {
+    return connections_accepted.load();
+}
+
+uint64_t OrderServer::getOrdersAccepted() const {
+    return orders_accepted.load();
+}
+
+uint64_t OrderServer::getOrdersRejected() const {
+    return orders_rejected.load();
+}
+
+uint64_t OrderServer::getNotificationsDropped() const {
+    return notifications_dropped.load();
+}
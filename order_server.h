@@ -0,0 +1,94 @@
+#pragma once
+#include <bits/stdc++.h>
+#include "order_protocol.h"
+
+using namespace std;
+
+class Order;
+class Pizzeria;
+
+// epoll-driven order intake. One event-loop thread owns every connection;
+// kitchen threads hand it status notifications through a fixed-size ring and
+// an eventfd wake-up. Connection slots and their buffers are allocated once
+// and reused, so steady-state request parsing and notification delivery do
+// not allocate.
+class OrderServer {
+private:
+    static constexpr size_t INPUT_BUFFER_SIZE = 4096;
+    static constexpr size_t OUTPUT_BUFFER_SIZE = 16384;
+    static constexpr size_t NOTIFY_RING_SIZE = 65536;
+
+    struct Connection {
+        int fd = -1;
+        uint32_t generation = 0;
+        unique_ptr<char[]> input;
+        size_t input_len = 0;
+        unique_ptr<char[]> output;
+        size_t output_head = 0;
+        size_t output_len = 0;
+        bool want_write = false;
+    };
+
+    struct Notification {
+        uint64_t origin;
+        OrderEventFrame frame;
+    };
+
+    Pizzeria& pizzeria;
+    OrderServerEndpoint endpoint;
+    size_t max_connections;
+
+    int listen_fd;
+    int epoll_fd;
+    int wake_fd;
+    atomic<bool> running{false};
+    thread loop_thread;
+
+    vector<Connection> connections;
+    vector<uint32_t> free_slots;
+
+    // Notification ring, filled by kitchen threads and drained by the loop
+    mutex notify_mutex;
+    vector<Notification> notify_ring;
+    size_t notify_head;
+    size_t notify_count;
+    atomic<uint64_t> notifications_dropped{0};
+
+    // Statistics
+    atomic<uint64_t> connections_accepted{0};
+    atomic<uint64_t> orders_accepted{0};
+    atomic<uint64_t> orders_rejected{0};
+
+    void eventLoop();
+    void acceptConnections();
+    void handleReadable(uint32_t slot);
+    void handleWritable(uint32_t slot);
+    void processFrames(uint32_t slot);
+    void drainNotifications();
+    bool queueFrame(uint32_t slot, const OrderEventFrame& frame);
+    bool flushOutput(uint32_t slot);
+    void updateInterest(uint32_t slot);
+    void closeConnection(uint32_t slot);
+
+public:
+    OrderServer(Pizzeria& p, const OrderServerEndpoint& ep, size_t max_conns = 4096);
+    ~OrderServer();
+
+    // Throws runtime_error if the endpoint cannot be bound.
+    void start();
+    void stop();
+
+    // Called from kitchen threads whenever a network-originated order changes
+    // state. Never blocks on the network.
+    void notifyOrderEvent(const Order& order, OrderEventType type);
+
+    const OrderServerEndpoint& getEndpoint() const;
+    uint64_t getConnectionsAccepted() const;
+    uint64_t getOrdersAccepted() const;
+    uint64_t getOrdersRejected() const;
+    uint64_t getNotificationsDropped() const;
+
+    static uint64_t makeOrigin(uint32_t slot, uint32_t generation);
+};
+
+uint32_t priceToCents(double price);
@@ -8,64 +8,34 @@ unique_ptr<Pizzeria> g_pizzeria;
 // Static member initialization
 atomic<int> Order::order_counter{1};
 
-// Ingredient implementation
-Ingredient::Ingredient(IngredientType t, const string& n, int q) 
-    : type(t), name(n), quantity(q) {}
-
-bool Ingredient::consume(int amount) {
-    lock_guard<mutex> lock(ingredient_mutex);
-    if (quantity >= amount) {
-        quantity -= amount;
-        return true;
+// Order implementation
+Order::Order(int cust_id, MenuItemId item) : Order(cust_id, &item, 1) {}
+
+Order::Order(int cust_id, const MenuItemId* line_items, size_t count)
+    : order_id(order_counter++), customer_id(cust_id), items{}, item_count(static_cast<uint8_t>(count)),
+      status(OrderStatus::PENDING), order_time(g_sim_clock.now()), stage_start(order_time),
+      price(0.0), is_paid(false), is_refunded(false), is_cancelled(false),
+      location(OrderLocation::NONE), origin(0), client_tag(0) {
+    if (count == 0 || count > MAX_ORDER_ITEMS) {
+        throw out_of_range("order: " + to_string(count) + " line items (1 to " + to_string(MAX_ORDER_ITEMS) + ")");
+    }
+    copy(line_items, line_items + count, items.begin());
+    for (size_t i = 0; i < count; ++i) {
+        price += g_catalog.getItemPrice(items[i]);
     }
-    return false;
-}
-
-void Ingredient::restock(int amount) {
-    lock_guard<mutex> lock(ingredient_mutex);
-    quantity += amount;
-}
-
-int Ingredient::getQuantity() const {
-    lock_guard<mutex> lock(ingredient_mutex);
-    return quantity;
-}
-
-string Ingredient::getName() const {
-    return name;
-}
-
-IngredientType Ingredient::getType() const {
-    return type;
 }
 
-// Order implementation
-Order::Order(int cust_id, PizzaType type) 
-    : order_id(order_counter++), customer_id(cust_id), pizza_type(type), 
-      status(OrderStatus::PENDING), order_time(chrono::steady_clock::now()),
-      price(0.0), is_paid(false), is_refunded(false) {
-    
-    // Set price based on pizza type
-    switch (type) {
-        case PizzaType::MARGHERITA:
-            price = 12.99;
-            break;
-        case PizzaType::PEPPERONI:
-            price = 15.99;
-            break;
-        case PizzaType::MUSHROOM:
-            price = 14.99;
-            break;
-        case PizzaType::VEGGIE:
-            price = 16.99;
-            break;
-        case PizzaType::SUPREME:
-            price = 19.99;
-            break;
-        default:
-            price = 12.99;
-            break;
+Order::Order(int id, int cust_id, const MenuItemId* line_items, size_t count, double paid_price,
+             chrono::steady_clock::time_point placed, chrono::steady_clock::time_point ready)
+    : order_id(id), customer_id(cust_id), items{}, item_count(static_cast<uint8_t>(count)),
+      status(OrderStatus::PENDING), order_time(placed),
+      ready_time(ready), stage_start(ready != chrono::steady_clock::time_point{} ? ready : placed),
+      price(paid_price), is_paid(false), is_refunded(false), is_cancelled(false), location(OrderLocation::NONE),
+      origin(0), client_tag(0) {
+    if (count == 0 || count > MAX_ORDER_ITEMS) {
+        throw out_of_range("order: " + to_string(count) + " line items (1 to " + to_string(MAX_ORDER_ITEMS) + ")");
     }
+    copy(line_items, line_items + count, items.begin());
 }
 
 double Order::getPrice() const {
@@ -73,25 +43,64 @@ double Order::getPrice() const {
 }
 
 void Order::setPaid(bool paid) {
-    lock_guard<mutex> lock(order_mutex);
+    lock_guard<ProfiledMutex> lock(order_mutex);
     is_paid = paid;
 }
 
 bool Order::isPaid() const {
-    lock_guard<mutex> lock(order_mutex);
+    lock_guard<ProfiledMutex> lock(order_mutex);
     return is_paid;
 }
 
 void Order::setRefunded(bool refunded) {
-    lock_guard<mutex> lock(order_mutex);
+    lock_guard<ProfiledMutex> lock(order_mutex);
     is_refunded = refunded;
 }
 
 bool Order::isRefunded() const {
-    lock_guard<mutex> lock(order_mutex);
+    lock_guard<ProfiledMutex> lock(order_mutex);
     return is_refunded;
 }
 
+bool Order::cancelBefore(OrderStatus limit) {
+    lock_guard<ProfiledMutex> lock(order_mutex);
+    if (is_cancelled || status >= limit) {
+        return false;
+    }
+    is_cancelled = true;
+    return true;
+}
+
+bool Order::isCancelled() const {
+    lock_guard<ProfiledMutex> lock(order_mutex);
+    return is_cancelled;
+}
+
+OrderLocation Order::getLocation() const {
+    return location;
+}
+
+void Order::setLocation(OrderLocation new_location) {
+    location = new_location;
+}
+
+KitchenProgress& Order::getKitchenProgress() {
+    return kitchen;
+}
+
+void Order::setOrigin(uint64_t origin_token, uint32_t tag) {
+    origin = origin_token;
+    client_tag = tag;
+}
+
+uint64_t Order::getOrigin() const {
+    return origin;
+}
+
+uint32_t Order::getClientTag() const {
+    return client_tag;
+}
+
 int Order::getOrderId() const {
     return order_id;
 }
@@ -100,22 +109,56 @@ int Order::getCustomerId() const {
     return customer_id;
 }
 
-PizzaType Order::getPizzaType() const {
-    return pizza_type;
+MenuItemId Order::getMenuItem() const {
+    return items[0];
+}
+
+size_t Order::getItemCount() const {
+    return item_count;
+}
+
+MenuItemId Order::getItem(size_t index) const {
+    return items[index];
+}
+
+const MenuItemId* Order::getItems() const {
+    return items.data();
 }
 
 OrderStatus Order::getStatus() const {
-    lock_guard<mutex> lock(order_mutex);
+    lock_guard<ProfiledMutex> lock(order_mutex);
     return status;
 }
 
-void Order::setStatus(OrderStatus new_status) {
-    lock_guard<mutex> lock(order_mutex);
+bool Order::setStatus(OrderStatus new_status) {
+    lock_guard<ProfiledMutex> lock(order_mutex);
+    if (is_cancelled) {
+        return false;
+    }
+    status = new_status;
+    return true;
+}
+
+optional<OrderStatus> Order::advanceStatus(OrderStatus new_status, chrono::steady_clock::time_point now,
+                                           chrono::steady_clock::time_point& previous_start) {
+    lock_guard<ProfiledMutex> lock(order_mutex);
+    if (is_cancelled) {
+        return nullopt;
+    }
+    OrderStatus previous = status;
+    previous_start = stage_start;
     status = new_status;
+    stage_start = now;
+    return previous;
+}
+
+chrono::steady_clock::time_point Order::getStageStart() const {
+    lock_guard<ProfiledMutex> lock(order_mutex);
+    return stage_start;
 }
 
-string Order::getPizzaName() const {
-    return pizzaTypeToString(pizza_type);
+string_view Order::getPizzaName() const {
+    return g_catalog.getItemName(items[0]);
 }
 
 double Order::getProcessingTime() const {
@@ -127,8 +170,24 @@ double Order::getProcessingTime() const {
     return 0.0;
 }
 
-void Order::markCompleted() {
-    completion_time = chrono::steady_clock::now();
+void Order::markReady(chrono::steady_clock::time_point at) {
+    ready_time = at;
+}
+
+void Order::markCompleted(chrono::steady_clock::time_point at) {
+    completion_time = at;
+}
+
+chrono::steady_clock::time_point Order::getOrderTime() const {
+    return order_time;
+}
+
+chrono::steady_clock::time_point Order::getReadyTime() const {
+    return ready_time;
+}
+
+chrono::steady_clock::time_point Order::getCompletionTime() const {
+    return completion_time;
 }
 
 // Chef implementation
@@ -142,7 +201,11 @@ Chef::~Chef() {
 void Chef::startWorking() {
     if (!is_working) {
         is_working = true;
-        chef_thread = thread(&Chef::work, this);
+        chef_thread = thread([this, actor = g_sim_clock.addActor()] {
+            g_placement.pinCurrentThread(WorkerRole::CHEF, chef_id - 1);
+            SimActorScope scope(actor);
+            work();
+        });
     }
 }
 
@@ -156,64 +219,114 @@ void Chef::stopWorking() {
 }
 
 void Chef::work() {
-    random_device rd;
-    mt19937 gen(rd());
-    uniform_int_distribution<> cooking_time(3000, 8000); // 3-8 seconds
+    SimRandom rng(simStream(SimStreamKind::CHEF, chef_id));
+    
+    if (g_tracer.isEnabled()) {
+        g_tracer.setThreadName("Chef " + to_string(chef_id) + " (" + name + ")");
+    }
     
     while (is_working && g_pizzeria->isOpen()) {
-        // Wait for an order
-        auto order = g_pizzeria->getNextOrder();
-        if (!order) {
-            this_thread::sleep_for(chrono::milliseconds(100));
-            continue;
+        // Wait for a line item; its order's ingredients are already reserved
+        PrepTask task = g_pizzeria->getNextTask();
+        if (!task) {
+            continue; // getNextTask already waited; re-check whether we are closing
         }
+        const auto& order = task.order;
+        bool lead = task.item == 0;
         
-        // Check and consume ingredients
-        if (!g_pizzeria->checkAndConsumeIngredients(order->getPizzaType())) {
-            g_pizzeria->printOrderStatus("Chef " + to_string(chef_id) + 
-                " (" + name + ") - Cannot prepare Order #" + 
-                to_string(order->getOrderId()) + " - Insufficient ingredients!");
-            
-            // Put the order back in queue
-            g_pizzeria->addOrder(order);
-            this_thread::sleep_for(chrono::milliseconds(500));
+        g_metrics.addGauge(MetricGauge::CHEFS_BUSY, 1);
+        if (!makeItem(task, rng, lead)) {
+            // Cancelled before cooking; cancelOrder has already returned the
+            // ingredients
+            g_metrics.addGauge(MetricGauge::CHEFS_BUSY, -1);
+            announce("dropped cancelled", *order, task.item);
             continue;
         }
+        if (!lead) {
+            g_metrics.addGauge(MetricGauge::CHEFS_BUSY, -1);
+            continue; // the lead chef joins the items
+        }
+        if (order->getItemCount() > 1) {
+            // Join: make the items no other chef has picked up, then wait
+            // for the ones still in someone else's oven
+            while (PrepTask extra = g_pizzeria->claimTask(order)) {
+                makeItem(extra, rng, false);
+            }
+            g_pizzeria->awaitItems(order);
+        }
         
-        // Start preparing
-        order->setStatus(OrderStatus::PREPARING);
-        g_pizzeria->printOrderStatus("Chef " + to_string(chef_id) + 
-            " (" + name + ") started preparing Order #" + 
-            to_string(order->getOrderId()) + " (" + order->getPizzaName() + ")");
-        
-        // Simulate preparation time
-        this_thread::sleep_for(chrono::milliseconds(1000 + cooking_time(gen) / 4));
-        
-        // Start cooking
-        order->setStatus(OrderStatus::COOKING);
-        g_pizzeria->printOrderStatus("Chef " + to_string(chef_id) + 
-            " (" + name + ") is cooking Order #" + 
-            to_string(order->getOrderId()) + " (" + order->getPizzaName() + ")");
-        
-        // Simulate cooking time
-        this_thread::sleep_for(chrono::milliseconds(cooking_time(gen)));
-        
-        // Mark as ready
-        order->setStatus(OrderStatus::READY);
-        g_pizzeria->printOrderStatus("Chef " + to_string(chef_id) + 
-            " (" + name + ") completed Order #" + 
-            to_string(order->getOrderId()) + " (" + order->getPizzaName() + ")");
-        
-        // Add to ready orders
+        // Mark as ready and add to ready orders
+        AllocationScope stage(AllocationStage::COMPLETE);
+        auto now = g_sim_clock.now();
+        g_pizzeria->setOrderStatus(order, OrderStatus::READY, now);
+        order->markReady(now);
+        g_metrics.addGauge(MetricGauge::CHEFS_BUSY, -1);
+        announce("completed", *order);
         g_pizzeria->addReadyOrder(order);
     }
 }
 
+bool Chef::makeItem(const PrepTask& task, SimRandom& rng, bool lead) {
+    auto cooking_time = [&rng] { return rng.uniformInt(COOK_TIME_MS); }; // 3-8 seconds
+    const auto& order = task.order;
+    // Only the lead moves the order along; everyone stops once it is cancelled.
+    // A helper's item goes into the oven under the queue lock, so a cancel
+    // either stops it first or leaves its ingredients spent.
+    auto proceed = [&](OrderStatus status) {
+        if (lead) {
+            return g_pizzeria->setOrderStatus(order, status);
+        }
+        return status == OrderStatus::COOKING ? g_pizzeria->startCooking(task) : !order->isCancelled();
+    };
+    bool multi_item = order->getItemCount() > 1;
+    auto start = multi_item ? g_sim_clock.now() : chrono::steady_clock::time_point{};
+
+    // Start preparing
+    {
+        AllocationScope stage(AllocationStage::PREPARE);
+        if (!proceed(OrderStatus::PREPARING)) {
+            return false;
+        }
+        announce("started preparing", *order, task.item);
+    }
+    
+    // Simulate preparation time
+    g_sim_clock.sleepFor(chrono::milliseconds(PREP_BASE_MS + cooking_time() / 4));
+    
+    // Start cooking
+    {
+        AllocationScope stage(AllocationStage::COOK);
+        if (!proceed(OrderStatus::COOKING)) {
+            return false;
+        }
+        announce("is cooking", *order, task.item);
+    }
+    
+    // Simulate cooking time
+    g_sim_clock.sleepFor(chrono::milliseconds(cooking_time()));
+    if (multi_item) {
+        g_pizzeria->finishItem(task, g_sim_clock.now() - start);
+    }
+    return true;
+}
+
+void Chef::announce(string_view action, const Order& order, size_t item) const {
+    AllocationScope scope(AllocationStage::STATUS_LINE);
+    StatusLine line;
+    line << "Chef " << chef_id << " (" << name << ") " << action << " Order #" << order.getOrderId() << " ("
+         << g_catalog.getItemName(order.getItem(item));
+    if (order.getItemCount() > 1) {
+        line << ", pizza " << item + 1 << "/" << order.getItemCount();
+    }
+    line << ")";
+    g_pizzeria->printOrderStatus(line.view());
+}
+
 int Chef::getChefId() const {
     return chef_id;
 }
 
-string Chef::getName() const {
+const string& Chef::getName() const {
     return name;
 }
 
@@ -222,68 +335,113 @@ Customer::Customer(int id, const string& customer_name)
     : customer_id(id), name(customer_name) {}
 
 Customer::~Customer() {
+    finishOrdering();
+}
+
+void Customer::finishOrdering() {
     if (customer_thread.joinable()) {
         customer_thread.join();
     }
 }
 
 void Customer::startOrdering() {
-    customer_thread = thread(&Customer::placeOrders, this);
+    customer_thread = thread([this, actor = g_sim_clock.addActor()] {
+        g_placement.pinCurrentThread(WorkerRole::INTAKE, customer_id - 1);
+        SimActorScope scope(actor);
+        placeOrders();
+    });
 }
 
 // Replace the Customer::placeOrders method:
 
 void Customer::placeOrders() {
-    random_device rd;
-    mt19937 gen(rd());
-    uniform_int_distribution<> pizza_choice(0, 4);
-    uniform_int_distribution<> order_interval(2000, 8000);
-    uniform_int_distribution<> orders_per_customer(1, 3);
+    SimRandom rng(simStream(SimStreamKind::CUSTOMER, customer_id));
+    int last_item = static_cast<int>(g_catalog.getItemCount()) - 1;
     
-    int num_orders = orders_per_customer(gen);
+    if (g_tracer.isEnabled()) {
+        g_tracer.setThreadName("Customer " + to_string(customer_id) + " (" + name + ")");
+    }
+
+    int num_orders = rng.uniformInt(ORDERS_PER_CUSTOMER);
     
     for (int i = 0; i < num_orders && g_pizzeria->isAcceptingOrders(); ++i) {
-        PizzaType pizza_type = static_cast<PizzaType>(pizza_choice(gen));
-        auto order = make_shared<Order>(customer_id, pizza_type);
-        
-        // Customer pays for the order
-        double price = order->getPrice();
-        order->setPaid(true);
-        
-        g_pizzeria->addOrder(order);
-        g_pizzeria->printOrderStatus("PAYMENT: Customer " + to_string(customer_id) + 
-            " (" + name + ") placed Order #" + to_string(order->getOrderId()) + 
-            " for " + order->getPizzaName() + " ($" + 
-            to_string(price).substr(0, to_string(price).find('.') + 3) + ") - PAID");
+        MenuItemId line_items[MAX_ORDER_ITEMS] = {static_cast<MenuItemId>(rng.uniformInt(0, last_item))};
+        size_t item_count = 1;
+        // Some orders feed a whole family (--family-orders)
+        int family_percent = g_pizzeria->getFamilyOrderPercent();
+        if (family_percent > 0 && rng.uniformInt(1, 100) <= family_percent) {
+            for (int extra = rng.uniformInt(FAMILY_EXTRA_ITEMS); extra > 0; --extra) {
+                line_items[item_count++] = static_cast<MenuItemId>(rng.uniformInt(0, last_item));
+            }
+        }
+        shared_ptr<Order> order;
+        {
+            AllocationScope stage(AllocationStage::PLACE_ORDER);
+            order = make_shared<Order>(customer_id, line_items, item_count);
+
+            // Customer pays for the order
+            double price = order->getPrice();
+            order->setPaid(true);
+
+            g_pizzeria->addOrder(order);
+            AllocationScope message(AllocationStage::STATUS_LINE);
+            StatusLine line;
+            line << "PAYMENT: Customer " << customer_id << " (" << name << ") placed Order #" << order->getOrderId()
+                 << " for ";
+            if (item_count > 1) {
+                line << item_count << " pizzas (";
+                for (size_t i = 0; i < item_count; ++i) {
+                    line << (i > 0 ? ", " : "") << g_catalog.getItemName(line_items[i]);
+                }
+                line << ")";
+            } else {
+                line << order->getPizzaName();
+            }
+            line << " ($" << Dollars{price} << ") - PAID";
+            g_pizzeria->printOrderStatus(line.view());
+        }
+
+        // Some customers change their mind a little later (--cancel-rate)
+        int cancel_percent = g_pizzeria->getCancelPercent();
+        if (cancel_percent > 0 && rng.uniformInt(1, 100) <= cancel_percent &&
+            !g_pizzeria->getShutdown().sleepUnless(ShutdownPhase::INTAKE_STOPPED,
+                chrono::milliseconds(rng.uniformInt(500, 4000)))) {
+            optional<double> refund = g_pizzeria->cancelOrder(order);
+            AllocationScope message(AllocationStage::STATUS_LINE);
+            StatusLine line;
+            line << "CANCEL: Customer " << customer_id << " (" << name << ") cancelled Order #"
+                 << order->getOrderId();
+            if (refund) {
+                line << " - refunded $" << Dollars{*refund} << " (Original: $" << Dollars{order->getPrice()}
+                     << " - 10% cancellation fee)";
+            } else {
+                line << " - too late, already cooking or on its way";
+            }
+            g_pizzeria->printOrderStatus(line.view());
+        }
         
-        if (i < num_orders - 1) {
-            this_thread::sleep_for(chrono::milliseconds(order_interval(gen)));
+        // Wait before the next order; stop early once intake closes
+        if (i < num_orders - 1 && g_pizzeria->getShutdown().sleepUnless(ShutdownPhase::INTAKE_STOPPED,
+                chrono::milliseconds(rng.uniformInt(ORDER_GAP_MS)))) {
+            break;
         }
     }
+    g_pizzeria->customerFinished();
 }
 
 int Customer::getCustomerId() const {
     return customer_id;
 }
 
-string Customer::getName() const {
+const string& Customer::getName() const {
     return name;
 }
 
 // Pizzeria implementation
 Pizzeria::Pizzeria(int num_chefs, int num_customers) 
     : chef_semaphore(num_chefs), ingredient_semaphore(1000), 
-      gen(rd()), pizza_dist(0, 4), timing_dist(1000, 5000) {
-    
-    // Initialize ingredients
-    ingredients.push_back(make_unique<Ingredient>(IngredientType::DOUGH, "Dough", 5));
-    ingredients.push_back(make_unique<Ingredient>(IngredientType::CHEESE, "Cheese", 10));
-    ingredients.push_back(make_unique<Ingredient>(IngredientType::TOMATO_SAUCE, "Tomato Sauce", 8));
-    ingredients.push_back(make_unique<Ingredient>(IngredientType::PEPPERONI, "Pepperoni", 6));
-    ingredients.push_back(make_unique<Ingredient>(IngredientType::MUSHROOMS, "Mushrooms", 4));
-    ingredients.push_back(make_unique<Ingredient>(IngredientType::OLIVES, "Olives", 3));
-    ingredients.push_back(make_unique<Ingredient>(IngredientType::BELL_PEPPERS, "Bell Peppers", 3));
-    
+      catalog(g_catalog), inventory(g_catalog), availability(g_catalog), metrics_exporter(g_metrics),
+      restock_rng(simStream(SimStreamKind::PIZZERIA)), history(g_sim_clock.now()) {
 
 // Create chefs
 vector<string> chef_names = {"Mario", "Luigi", "Giuseppe", "Antonio", "Francesco", "Giovanni"};
@@ -306,86 +464,442 @@ Pizzeria::~Pizzeria() {
 
 void Pizzeria::addOrder(shared_ptr<Order> order) {
     // order_queue is buffer queue b/w customer placing order and chef processing it
-    lock_guard<mutex> lock(order_queue_mutex);
-    order_queue.push(order);
+    order_index.insert(static_cast<uint32_t>(order->getOrderId()), static_cast<uint8_t>(OrderStatus::PENDING));
+    lock_guard<ProfiledMutex> lock(order_queue_mutex);
+    order->setLocation(OrderLocation::ORDER_QUEUE);
+    order_queue.push_back(order);
     total_orders_placed++;
+    g_metrics.increment(MetricCounter::ORDERS_PLACED);
+    g_metrics.setGauge(MetricGauge::ORDER_QUEUE_DEPTH, order_queue.size() - cancelled_queued);
     order_available.notify_one();
 }
 
-shared_ptr<Order> Pizzeria::getNextOrder() {
-    unique_lock<mutex> lock(order_queue_mutex);// this ensures only one thread accesses the queue at a time
-    // Wait for an order to be available or pizzeria to close
-    order_available.wait(lock, [this] { return !order_queue.empty() || !is_open; });
+PrepTask Pizzeria::getNextTask() {
+    ProfiledLock lock(order_queue_mutex);// this ensures only one thread accesses the queue at a time
+    // Wait for work to be available or pizzeria to close
+    g_sim_clock.wait(lock, order_available, [this] {
+        return !prep_tasks.empty() || order_queue.size() > cancelled_queued || !is_open;
+    });
     
-    if (!order_queue.empty()) {
-        auto order = order_queue.front();
-        order_queue.pop();
+    // Finish what is in the kitchen before starting new orders
+    if (PrepTask task = claimQueuedTask()) {
+        return task;
+    }
+    if (auto order = takeMakeableOrder()) {
+        return forkOrder(order);
+    }
+    if (order_queue.size() == cancelled_queued) {
+        return {};
+    }
+
+    // Nothing queued can be made with current stock; wait for a restock or a
+    // new order instead of popping and failing
+    bool newly_blocked = !ingredients_blocked;
+    ingredients_blocked = true;
+    size_t waiting = order_queue.size() - cancelled_queued;
+    if (newly_blocked) {
+        lock.unlock(); // never hold order_queue_mutex while taking cout_mutex
+        printOrderStatus("KITCHEN: " + to_string(waiting) + " queued orders waiting for ingredients");
+        lock.lock();
+    }
+    g_sim_clock.waitFor(lock, order_available, chrono::milliseconds(500));
+    if (PrepTask task = claimQueuedTask()) {
+        return task;
+    }
+    auto order = takeMakeableOrder();
+    return order ? forkOrder(order) : PrepTask{};
+}
+
+// Caller holds order_queue_mutex. The dispatching chef leads the order with
+// item 0; the rest are offered to idle chefs unless preparation is serial.
+PrepTask Pizzeria::forkOrder(const shared_ptr<Order>& order) {
+    size_t count = order->getItemCount();
+    if (count > 1) {
+        KitchenProgress& progress = order->getKitchenProgress();
+        progress.claimed = 1;
+        progress.unfinished = static_cast<uint8_t>(count);
+        progress.dispatched = g_sim_clock.now();
+        if (parallel_prep) {
+            prep_tasks.push_back(order);
+            order_available.notify_all();
+        }
+    }
+    return {order, 0};
+}
+
+// Caller holds order_queue_mutex
+PrepTask Pizzeria::claimQueuedTask() {
+    if (prep_tasks.empty()) {
+        return {};
+    }
+    auto order = prep_tasks.front();
+    KitchenProgress& progress = order->getKitchenProgress();
+    uint8_t item = progress.claimed++;
+    if (progress.claimed == order->getItemCount()) {
+        prep_tasks.pop_front();
+    }
+    return {move(order), item};
+}
+
+PrepTask Pizzeria::claimTask(const shared_ptr<Order>& order) {
+    lock_guard<ProfiledMutex> lock(order_queue_mutex);
+    KitchenProgress& progress = order->getKitchenProgress();
+    if (progress.claimed == order->getItemCount()) {
+        return {};
+    }
+    uint8_t item = progress.claimed++;
+    if (progress.claimed == order->getItemCount()) {
+        // Few multi-item orders are in the kitchen at once
+        auto it = find(prep_tasks.begin(), prep_tasks.end(), order);
+        if (it != prep_tasks.end()) {
+            prep_tasks.erase(it);
+        }
+    }
+    return {order, item};
+}
+
+void Pizzeria::finishItem(const PrepTask& task, chrono::nanoseconds work) {
+    lock_guard<ProfiledMutex> lock(order_queue_mutex);
+    KitchenProgress& progress = task.order->getKitchenProgress();
+    progress.work += work;
+    if (--progress.unfinished == 0) {
+        item_finished.notify_all();
+    }
+}
+
+bool Pizzeria::startCooking(const PrepTask& task) {
+    lock_guard<ProfiledMutex> lock(order_queue_mutex);
+    if (task.order->isCancelled()) {
+        return false;
+    }
+    task.order->getKitchenProgress().cooking |= static_cast<uint8_t>(1u << task.item);
+    return true;
+}
+
+void Pizzeria::awaitItems(const shared_ptr<Order>& order) {
+    KitchenProgress progress;
+    {
+        ProfiledLock lock(order_queue_mutex);
+        g_sim_clock.wait(lock, item_finished, [&order] { return order->getKitchenProgress().unfinished == 0; });
+        progress = order->getKitchenProgress();
+    }
+    auto in_kitchen = g_sim_clock.now() - progress.dispatched;
+    multi_item_orders++;
+    multi_item_kitchen_ns += chrono::duration_cast<chrono::nanoseconds>(in_kitchen).count();
+    multi_item_work_ns += progress.work.count();
+    g_metrics.recordLatency(MetricHistogram::MULTI_ITEM_KITCHEN, in_kitchen);
+    g_metrics.recordLatency(MetricHistogram::MULTI_ITEM_WORK, progress.work);
+}
+
+void Pizzeria::setParallelPrep(bool enabled) {
+    parallel_prep = enabled;
+}
+
+// Caller holds order_queue_mutex. Picks the oldest order whose recipe fits the
+// current stock and reserves its ingredients.
+shared_ptr<Order> Pizzeria::takeMakeableOrder() {
+    if (order_queue.empty()) {
+        return nullptr;
+    }
+    TraceScope span("dispatch scan");
+
+    availability.loadStock(inventory, dispatch_stock);
+    dispatch_counts.resize(availability.getItemCount());
+    availability.computeItemCounts(dispatch_stock.data(), dispatch_counts.data());
+
+    for (auto it = order_queue.begin(); it != order_queue.end(); ++it) {
+        const Order& candidate = **it;
+        if (candidate.getLocation() == OrderLocation::CANCELLED) {
+            continue;
+        }
+        if (candidate.getItemCount() > 1) {
+            // Every pizza must be makeable on its own; the combined recipes
+            // are checked by the all-or-nothing reservation
+            const MenuItemId* items = candidate.getItems();
+            bool makeable = all_of(items, items + candidate.getItemCount(),
+                                   [this](MenuItemId item) { return dispatch_counts[item] > 0; });
+            if (!makeable || !inventory.reserve(catalog, items, candidate.getItemCount())) {
+                continue;
+            }
+        } else {
+            MenuItemId item = candidate.getMenuItem();
+            if (dispatch_counts[item] <= 0) {
+                continue;
+            }
+            if (!checkAndConsumeIngredients(item)) {
+                dispatch_counts[item] = 0; // lost a race with a concurrent reservation
+                continue;
+            }
+        }
+        auto order = *it;
+        order_queue.erase(it);
+        {
+            lock_guard<ProfiledMutex> ready_lock(ready_orders_mutex);
+            order->setLocation(OrderLocation::KITCHEN);
+            kitchen_orders.push_back(order);
+        }
+        g_metrics.setGauge(MetricGauge::ORDER_QUEUE_DEPTH, order_queue.size() - cancelled_queued);
+        ingredients_blocked = false;
         return order;
     }
+
+    g_metrics.increment(MetricCounter::INGREDIENT_SHORTAGES);
     return nullptr;
 }
 
+size_t Pizzeria::countMakeableQueuedOrders() {
+    lock_guard<ProfiledMutex> lock(order_queue_mutex);
+    vector<MenuItemId> items;
+    items.reserve(order_queue.size());
+    vector<uint8_t> item_counts;  // line items per live order, in queue order
+    for (const auto& order : order_queue) {
+        if (order->getLocation() != OrderLocation::CANCELLED) {
+            items.insert(items.end(), order->getItems(), order->getItems() + order->getItemCount());
+            item_counts.push_back(static_cast<uint8_t>(order->getItemCount()));
+        }
+    }
+    vector<int32_t> stock;
+    availability.loadStock(inventory, stock);
+    vector<uint8_t> makeable(items.size());
+    size_t makeable_items = availability.planQueue(stock.data(), items.data(), items.size(), makeable.data());
+    if (items.size() == item_counts.size()) {
+        return makeable_items;
+    }
+    // Multi-item orders count when all of their pizzas fit (the plan still
+    // sets aside stock for the ones that do)
+    size_t makeable_orders = 0;
+    for (size_t i = 0, first = 0; i < item_counts.size(); first += item_counts[i++]) {
+        makeable_orders += all_of(makeable.begin() + first, makeable.begin() + first + item_counts[i],
+                                  [](uint8_t flag) { return flag != 0; });
+    }
+    return makeable_orders;
+}
+
+// Orders in hand are few (one per chef or driver), so a linear scan it is
+static void eraseOrder(vector<shared_ptr<Order>>& orders, const shared_ptr<Order>& order) {
+    auto it = find(orders.begin(), orders.end(), order);
+    if (it != orders.end()) {
+        *it = move(orders.back());
+        orders.pop_back();
+    }
+}
+
+// Caller holds the queue's mutex. Tombstones at either end go right away; the
+// rest once they outnumber live orders, so a cancellation costs O(1)
+// amortized and scans never walk more dead entries than live ones.
+static void purgeCancelled(deque<shared_ptr<Order>>& queue, size_t& cancelled) {
+    auto isCancelled = [](const shared_ptr<Order>& order) {
+        return order->getLocation() == OrderLocation::CANCELLED;
+    };
+    while (!queue.empty() && isCancelled(queue.front())) {
+        queue.pop_front();
+        cancelled--;
+    }
+    while (!queue.empty() && isCancelled(queue.back())) {
+        queue.pop_back();
+        cancelled--;
+    }
+    if (cancelled * 2 > queue.size()) {
+        erase_if(queue, isCancelled);
+        cancelled = 0;
+    }
+}
+
 void Pizzeria::addReadyOrder(shared_ptr<Order> order) {
-    lock_guard<mutex> lock(ready_orders_mutex);// releases the mutex when it goes out of scope
-    ready_orders.push(order);
+    lock_guard<ProfiledMutex> lock(ready_orders_mutex);// releases the mutex when it goes out of scope
+    eraseOrder(kitchen_orders, order);
+    order->setLocation(OrderLocation::READY_QUEUE);
+    ready_orders.push_back(order);
     total_orders_completed++;
+    g_metrics.increment(MetricCounter::ORDERS_COMPLETED);
+    g_metrics.setGauge(MetricGauge::READY_QUEUE_DEPTH, ready_orders.size() - cancelled_ready);
+    g_metrics.recordLatency(MetricHistogram::ORDER_TO_READY,
+        order->getReadyTime() - order->getOrderTime());
     ready_order_available.notify_one();// notify waiting threads that a new order is ready
+    shutdown.signal();
 }
 
 shared_ptr<Order> Pizzeria::getReadyOrder() {
-    unique_lock<mutex> lock(ready_orders_mutex);
-    ready_order_available.wait_for(lock, chrono::milliseconds(1000), 
-        [this] { return !ready_orders.empty() || !is_open; });
+    ProfiledLock lock(ready_orders_mutex);
+    g_sim_clock.waitFor(lock, ready_order_available, chrono::milliseconds(1000),
+        [this] { return ready_orders.size() > cancelled_ready || !is_open; });
     
+    purgeCancelled(ready_orders, cancelled_ready); // the front is live afterwards
     if (!ready_orders.empty()) {
         auto order = ready_orders.front();
-        ready_orders.pop();
+        ready_orders.pop_front();
+        order->setLocation(OrderLocation::DELIVERY);
+        delivery_orders.push_back(order);
+        g_metrics.setGauge(MetricGauge::READY_QUEUE_DEPTH, ready_orders.size() - cancelled_ready);
         return order;
     }
     return nullptr;
 }
 
-bool Pizzeria::checkAndConsumeIngredients(PizzaType pizza_type) {
-    auto required_ingredients = getRequiredIngredients(pizza_type);
-    
-    // Check if all ingredients are available
-    for (auto ingredient_type : required_ingredients) {
-        auto it = find_if(ingredients.begin(), ingredients.end(),
-            [ingredient_type](const unique_ptr<Ingredient>& ing) {
-                return ing->getType() == ingredient_type;
-            });
-        
-        if (it == ingredients.end() || (*it)->getQuantity() < 1) {
+// Lifecycle stage names used for trace spans, indexed by OrderStatus
+static constexpr const char* ORDER_STAGE_TRACE_NAMES[] = {
+    "queued", "preparing", "cooking", "ready", "out for delivery", "delivered"
+};
+
+// Stages during which the thread closing the span was doing the work; these
+// also appear on that thread's row (chef prep and cooking, driver delivery)
+static constexpr bool isWorkStage(OrderStatus status) {
+    return status == OrderStatus::PREPARING || status == OrderStatus::COOKING ||
+           status == OrderStatus::OUT_FOR_DELIVERY;
+}
+
+static string formatSeconds(chrono::nanoseconds duration) {
+    ostringstream text;
+    text << fixed << setprecision(2) << chrono::duration<double>(duration).count() << "s";
+    return text.str();
+}
+
+static void traceOrderStage(const Order& order, OrderStatus stage,
+                            chrono::steady_clock::time_point start, chrono::steady_clock::time_point end) {
+    g_tracer.recordOrderStage(ORDER_STAGE_TRACE_NAMES[static_cast<int>(stage)], order.getOrderId(),
+        start, end, isWorkStage(stage));
+}
+
+bool Pizzeria::setOrderStatus(const shared_ptr<Order>& order, OrderStatus new_status) {
+    // One clock read both closes the stage being left and opens the next
+    return setOrderStatus(order, new_status, g_tracer.isEnabled() ? g_sim_clock.now() : chrono::steady_clock::time_point{});
+}
+
+bool Pizzeria::setOrderStatus(const shared_ptr<Order>& order, OrderStatus new_status,
+                              chrono::steady_clock::time_point now) {
+    if (g_tracer.isEnabled()) {
+        chrono::steady_clock::time_point stage_start;
+        optional<OrderStatus> previous = order->advanceStatus(new_status, now, stage_start);
+        if (!previous) {
             return false;
         }
+        traceOrderStage(*order, *previous, stage_start, now);
+    } else if (!order->setStatus(new_status)) {
+        return false;
     }
-    
-    // Consume ingredients
-    for (auto ingredient_type : required_ingredients) {
-        auto it = find_if(ingredients.begin(), ingredients.end(),
-            [ingredient_type](const unique_ptr<Ingredient>& ing) {
-                return ing->getType() == ingredient_type;
-            });
-        
-        if (it != ingredients.end()) {
-            (*it)->consume(1);// decrease by 1 unit
-        }
+    order_index.update(static_cast<uint32_t>(order->getOrderId()), static_cast<uint8_t>(new_status));
+    if (order->getOrigin() != 0 && order_server) {
+        order_server->notifyOrderEvent(*order, new_status == OrderStatus::DELIVERED
+            ? OrderEventType::DELIVERED : OrderEventType::STATUS);
     }
-    
     return true;
 }
 
+optional<double> Pizzeria::cancelOrder(const shared_ptr<Order>& order) {
+    double refund = 0.0;
+    {
+        // Both locks: the order may be in either queue or in between, and
+        // the ledger changes together with the queues for snapshots
+        lock_guard<ProfiledMutex> order_lock(order_queue_mutex);
+        lock_guard<ProfiledMutex> ready_lock(ready_orders_mutex);
+        OrderLocation location = order->getLocation();
+        // Chefs give an order back until it goes into the oven
+        OrderStatus limit = location == OrderLocation::KITCHEN ? OrderStatus::COOKING : OrderStatus::OUT_FOR_DELIVERY;
+        bool in_reach = location == OrderLocation::ORDER_QUEUE || location == OrderLocation::KITCHEN ||
+                        location == OrderLocation::READY_QUEUE;
+        if (!in_reach || !order->cancelBefore(limit)) {
+            return nullopt;
+        }
+        order->setLocation(OrderLocation::CANCELLED);
+        if (location == OrderLocation::ORDER_QUEUE) {
+            cancelled_queued++;
+            purgeCancelled(order_queue, cancelled_queued);
+            g_metrics.setGauge(MetricGauge::ORDER_QUEUE_DEPTH, order_queue.size() - cancelled_queued);
+        } else if (location == OrderLocation::KITCHEN) {
+            eraseOrder(kitchen_orders, order);
+            erase(prep_tasks, order);
+            // The lead's item is not cooking yet (or the cancel would have
+            // failed); helpers' items may be
+            uint8_t cooking = order->getKitchenProgress().cooking;
+            for (size_t i = 0; i < order->getItemCount(); ++i) {
+                if (!(cooking & (1u << i))) {
+                    inventory.release(catalog, order->getItem(i));
+                }
+            }
+            order_available.notify_all(); // returned stock may unblock queued orders
+        } else {
+            cancelled_ready++;
+            purgeCancelled(ready_orders, cancelled_ready);
+            g_metrics.setGauge(MetricGauge::READY_QUEUE_DEPTH, ready_orders.size() - cancelled_ready);
+        }
+        if (order->isPaid()) {
+            refund = calculateCancellationRefund(order->getPrice());
+            cancellation_refunds.fetch_add(refund);
+            cancellation_fees.fetch_add(order->getPrice() - refund);
+            order->setRefunded(true);
+        }
+        total_orders_cancelled++;
+        if (location != OrderLocation::READY_QUEUE) {
+            kitchen_cancellations++;
+        }
+    }
+
+    AllocationScope stage(AllocationStage::REFUND);
+    recordHistory(*order);
+    g_metrics.increment(MetricCounter::ORDERS_CANCELLED);
+    if (g_tracer.isEnabled()) {
+        // The order's last stage ends with the cancellation
+        traceOrderStage(*order, order->getStatus(), order->getStageStart(), g_sim_clock.now());
+    }
+    if (order->getOrigin() != 0 && order_server) {
+        order_server->notifyOrderEvent(*order, OrderEventType::REFUNDED);
+    }
+    shutdown.signal();
+    return refund;
+}
+
+void Pizzeria::enableCancellations(int percent) {
+    cancel_percent = clamp(percent, 0, 100);
+}
+
+void Pizzeria::enableFamilyOrders(int percent) {
+    family_percent = clamp(percent, 0, 100);
+}
+
+void Pizzeria::enableOrderServer(const OrderServerEndpoint& endpoint) {
+    order_server = make_unique<OrderServer>(*this, endpoint);
+}
+
+bool Pizzeria::checkAndConsumeIngredients(MenuItemId item) {
+    // All-or-nothing reservation of the whole recipe
+    return inventory.reserve(catalog, item);
+}
+
 void Pizzeria::restockIngredients() {
-    uniform_int_distribution<> restock_amount(5, 20);
-    for (auto& ingredient : ingredients) {
-        ingredient->restock(restock_amount(gen));
+    for (size_t i = 0; i < inventory.size(); ++i) {
+        inventory.restock(static_cast<IngredientId>(i), restock_rng.uniformInt(RESTOCK_AMOUNT));
     }
 }
 
 void Pizzeria::startOperations() {
+    // The operations loop is itself a scheduled actor under virtual time
+    SimActorScope operations(g_sim_clock.addActor());
+
     printOrderStatus("*** Welcome to Concurrent Pizzeria! ***");
-    printOrderStatus("PIZZA PRICES: Margherita $12.99 | Pepperoni $15.99 | Mushroom $14.99 | Veggie $16.99 | Supreme $19.99");
+    if (catalog.getItemCount() <= 10) {
+        string price_list = "PIZZA PRICES:";
+        for (size_t i = 0; i < catalog.getItemCount(); ++i) {
+            auto item = static_cast<MenuItemId>(i);
+            ostringstream price;
+            price << fixed << setprecision(2) << catalog.getItemPrice(item);
+            price_list += (i == 0 ? " " : " | ") + string(catalog.getItemName(item)) + " $" + price.str();
+        }
+        printOrderStatus(price_list);
+    } else {
+        printOrderStatus("MENU: " + to_string(catalog.getItemCount()) + " pizzas, " +
+            to_string(catalog.getIngredientCount()) + " ingredients");
+    }
     printOrderStatus("Opening for business...");
+
+    if (order_server) {
+        order_server->start();
+        printOrderStatus("ORDER SERVER: Accepting orders on " + order_server->getEndpoint().toString());
+    }
+
+    if (metrics_exporter.start([] { g_placement.pinCurrentThread(WorkerRole::SERVICE, 3); })) {
+        printOrderStatus("METRICS: Live metrics published to shared memory " +
+            string(METRICS_DEFAULT_SHM_NAME) + " (attach with pizzeria_monitor)");
+    }
     
     // Start chefs
     for (auto& chef : chefs) {
@@ -393,72 +907,140 @@ void Pizzeria::startOperations() {
     }
     
     // Start customers
+    active_customers = static_cast<int>(customers.size());
     for (auto& customer : customers) {
         customer->startOrdering();
     }
     
     // Start service threads
-    thread delivery_thread(&Pizzeria::deliveryService, this);
-    thread ingredient_thread(&Pizzeria::ingredientManager, this);
-    thread stats_thread(&Pizzeria::statisticsReporter, this);
+    auto startActor = [this](void (Pizzeria::*service)(), WorkerRole role, int index) {
+        return thread([this, service, role, index, actor = g_sim_clock.addActor()] {
+            g_placement.pinCurrentThread(role, index);
+            SimActorScope scope(actor);
+            (this->*service)();
+        });
+    };
+    thread delivery_thread = startActor(&Pizzeria::deliveryService, WorkerRole::DRIVER, 0);
+    thread ingredient_thread = startActor(&Pizzeria::ingredientManager, WorkerRole::SERVICE, 0);
+    thread stats_thread = startActor(&Pizzeria::statisticsReporter, WorkerRole::SERVICE, 1);
+    thread checkpoint_thread;
+    if (!checkpoint_path.empty()) {
+        checkpoint_thread = startActor(&Pizzeria::checkpointService, WorkerRole::SERVICE, 2);
+    }
     
-    // Run for reduced time: 25 seconds instead of 30
-    this_thread::sleep_for(chrono::seconds(25));
+    // Intake: up to 25 seconds, or until every customer has placed all of
+    // their orders (socket clients can order at any time, so with an order
+    // server the full window is kept)
+    shutdown.waitUntil([this] { return active_customers.load() == 0 && !order_server; },
+        INTAKE_WINDOW);
     
     // Stop accepting new orders
     accepting_orders = false;
+    shutdown.advance(ShutdownPhase::INTAKE_STOPPED);
     printOrderStatus("WARNING: Pizzeria closed for new orders. Processing remaining orders...");
     
-    // Reduced waiting time: 35 seconds instead of 65 (total: 60s instead of 90s)
-    int wait_cycles = 0;
-    const int max_wait_cycles = 50; // Changed from 65 to 35 seconds
-    
-    while (wait_cycles < max_wait_cycles) {
-        this_thread::sleep_for(chrono::seconds(1));
-        wait_cycles++;
-        
-        // Check if all orders are processed
-        bool orders_remaining = false;
-        {
-            lock_guard<mutex> order_lock(order_queue_mutex);
-            lock_guard<mutex> ready_lock(ready_orders_mutex);
-            orders_remaining = !order_queue.empty() || !ready_orders.empty();
-        }
-        
-        if (!orders_remaining && total_orders_placed == total_orders_delivered) {
-            printOrderStatus("SUCCESS: All orders completed and delivered!");
-            break;
-        }
-        
-        // Progress updates
-        if (wait_cycles % 5 == 0) {
-            printOrderStatus("PROCESSING: " + to_string(total_orders_delivered) + "/" + 
-                           to_string(total_orders_placed) + " delivered");
-        }
-
-        if (wait_cycles % 10 == 0) {
-            order_available.notify_all();
-            ready_order_available.notify_all();
+    // Drain the kitchen, then deliveries, within a shared 50-second budget.
+    // Each wait ends as soon as the last order clears that stage.
+    auto deadline = g_sim_clock.now() + DRAIN_BUDGET;
+    auto drainUntil = [&](auto drained) {
+        while (!drained()) {
+            auto remaining = deadline - g_sim_clock.now();
+            if (remaining <= chrono::nanoseconds::zero()) {
+                return false;
+            }
+            // Progress update every 5 seconds while waiting
+            if (!shutdown.waitUntil(drained, min<chrono::nanoseconds>(remaining, chrono::seconds(5)))) {
+                printOrderStatus("PROCESSING: " + to_string(total_orders_delivered) + "/" + 
+                               to_string(total_orders_placed - total_orders_cancelled) + " delivered");
+            }
         }
+        return true;
+    };
+    // Cancelled orders leave either stage early: those cancelled before they
+    // were ready never complete, and none of them is delivered
+    bool drained = drainUntil([this] {
+        return total_orders_completed.load() + kitchen_cancellations.load() >= total_orders_placed.load();
+    });
+    if (drained) {
+        shutdown.advance(ShutdownPhase::KITCHEN_DRAINED);
+        drained = drainUntil([this] {
+            return total_orders_delivered.load() + total_orders_cancelled.load() >= total_orders_placed.load();
+        });
     }
+    shutdown.advance(ShutdownPhase::DELIVERY_DRAINED);
     
-    if (wait_cycles >= max_wait_cycles) {
+    if (drained) {
+        printOrderStatus("SUCCESS: All orders completed and delivered!");
+    } else {
         printOrderStatus("TIMEOUT: 75-second time limit reached!");
     }
     
     // Process refunds for undelivered orders
     processRefunds();
+    shutdown.advance(ShutdownPhase::SETTLED);
+    if (!checkpoint_path.empty()) {
+        writeCheckpoint(); // settled state: stock, counters and ledger
+    }
     
-    // Close pizzeria
+    // Close pizzeria; wakes every waiting worker
     is_open = false;
+    shutdown.advance(ShutdownPhase::CLOSED);
     order_available.notify_all();
     ready_order_available.notify_all();
+    printOrderStatus("SHUTDOWN: intake " + formatSeconds(shutdown.getPhaseDuration(ShutdownPhase::OPEN)) +
+        ", kitchen drain " + formatSeconds(shutdown.getPhaseDuration(ShutdownPhase::INTAKE_STOPPED)) +
+        ", delivery drain " + formatSeconds(shutdown.getPhaseDuration(ShutdownPhase::KITCHEN_DRAINED)) +
+        ", refunds " + formatSeconds(shutdown.getPhaseDuration(ShutdownPhase::DELIVERY_DRAINED)));
     
-    // Wait for threads
+    // Wait for threads; they need the run token to finish
+    operations.leave();
     if (delivery_thread.joinable()) delivery_thread.join();
     if (ingredient_thread.joinable()) ingredient_thread.join();
     if (stats_thread.joinable()) stats_thread.join();
+    if (checkpoint_thread.joinable()) checkpoint_thread.join();
+    // Chefs and customers too, while everything they use is still alive:
+    // left to the destructor, they could outlive the globals at exit
+    for (auto& chef : chefs) {
+        chef->stopWorking();
+    }
+    for (auto& customer : customers) {
+        customer->finishOrdering();
+    }
     
+    metrics_exporter.stop();
+
+    if (g_placement.getPolicy() != PlacementPolicy::NONE) {
+        printOrderStatus("PLACEMENT: " + to_string(g_placement.getPinnedThreads()) + " threads pinned (" +
+            string(placementPolicyToString(g_placement.getPolicy())) + "), " +
+            to_string(g_placement.getFailedPins()) + " refused");
+    }
+
+    if (order_server) {
+        order_server->stop();
+        printOrderStatus("ORDER SERVER: " + to_string(order_server->getConnectionsAccepted()) +
+            " connections, " + to_string(order_server->getOrdersAccepted()) + " orders accepted, " +
+            to_string(order_server->getOrdersRejected()) + " rejected");
+    }
+
+    if (multi_item_orders > 0) {
+        // Fork/join pays off when chef work per order exceeds its time in the kitchen
+        double orders = multi_item_orders.load();
+        double kitchen_s = multi_item_kitchen_ns.load() / orders / 1e9;
+        double work_s = multi_item_work_ns.load() / orders / 1e9;
+        StatusLine line;
+        line << "KITCHEN: " << multi_item_orders.load() << " multi-item orders averaged " << Decimal{kitchen_s, 1}
+             << "s from dispatch to the last pizza, for " << Decimal{work_s, 1} << "s of chef work ("
+             << (parallel_prep ? "parallel" : "serial") << " preparation, " << Decimal{work_s / kitchen_s, 2}
+             << "x)";
+        printOrderStatus(line.view());
+    }
+
+    if (checkpoints_written > 0) {
+        printOrderStatus("CHECKPOINT: " + to_string(checkpoints_written) + " snapshots written to " +
+            checkpoint_path + ", longest pause " +
+            to_string(chrono::duration_cast<chrono::microseconds>(longest_checkpoint_pause).count()) + "us");
+    }
+
     printOrderStatus("FINAL: Pizzeria closed. Final reports:");
     printStatistics();
     printCompletionAnalysis();
@@ -468,12 +1050,21 @@ void Pizzeria::startOperations() {
 void Pizzeria::stopOperations() {
     is_open = false;
     accepting_orders = false;
+    shutdown.advance(ShutdownPhase::CLOSED);
     order_available.notify_all();
     ready_order_available.notify_all();
 }
 
-void Pizzeria::printOrderStatus(const string& message) {
-    lock_guard<mutex> lock(cout_mutex);
+void Pizzeria::printOrderStatus(string_view message) {
+    lock_guard<ProfiledMutex> lock(cout_mutex);
+    if (g_sim_clock.isVirtual()) {
+        // Simulated time since opening, so reruns print identical logs
+        auto elapsed = chrono::duration_cast<chrono::milliseconds>(g_sim_clock.elapsed()).count();
+        cout << "[+" << setfill('0') << setw(2) << elapsed / 3600000 << ":" << setw(2) << elapsed / 60000 % 60
+             << ":" << setw(2) << elapsed / 1000 % 60 << "." << setw(3) << elapsed % 1000 << "] ";
+        cout << message << endl;
+        return;
+    }
     auto now = chrono::system_clock::now();
     auto time_t = chrono::system_clock::to_time_t(now);
     auto ms = chrono::duration_cast<chrono::milliseconds>(
@@ -487,18 +1078,37 @@ void Pizzeria::printOrderStatus(const string& message) {
 // Replace the printStatistics method:
 
 void Pizzeria::printStatistics() {
-    lock_guard<mutex> lock(cout_mutex);
+    size_t makeable_orders = countMakeableQueuedOrders();
+    size_t queued_orders = 0;
+    size_t waiting_ready = 0;
+    {
+        lock_guard<ProfiledMutex> order_lock(order_queue_mutex);
+        lock_guard<ProfiledMutex> ready_lock(ready_orders_mutex);
+        queued_orders = order_queue.size() - cancelled_queued;
+        waiting_ready = ready_orders.size() - cancelled_ready;
+    }
+    lock_guard<ProfiledMutex> lock(cout_mutex);
     cout << "\n" << string(50, '=') << endl;
     cout << "PIZZERIA STATISTICS" << endl;
     cout << string(50, '=') << endl;
     cout << "Total Orders Placed: " << total_orders_placed << endl;
     cout << "Total Orders Completed: " << total_orders_completed << endl;
     cout << "Total Orders Delivered: " << total_orders_delivered << endl;
-    cout << "Orders in Queue: " << order_queue.size() << endl;
-    cout << "Ready Orders: " << ready_orders.size() << endl;
-    cout << "\nINGREDIENT LEVELS:" << endl;
-    for (const auto& ingredient : ingredients) {
-        cout << "  " << ingredient->getName() << ": " << ingredient->getQuantity() << endl;
+    cout << "Orders in Queue: " << queued_orders << " (" << makeable_orders
+         << " makeable now)" << endl;
+    cout << "Ready Orders: " << waiting_ready << endl;
+    if (total_orders_cancelled > 0) {
+        cout << "Orders Cancelled: " << total_orders_cancelled << endl;
+    }
+    cout << "Orders In Flight: " << order_index.size() << endl;
+    // Large menus only list the ingredients that are running low
+    bool show_all = inventory.size() <= 16;
+    cout << "\nINGREDIENT LEVELS" << (show_all ? "" : " (below 10 units)") << ":" << endl;
+    for (size_t i = 0; i < inventory.size(); ++i) {
+        auto ingredient = static_cast<IngredientId>(i);
+        if (show_all || inventory.getQuantity(ingredient) < 10) {
+            cout << "  " << catalog.getIngredientName(ingredient) << ": " << inventory.getQuantity(ingredient) << endl;
+        }
     }
     cout << string(50, '=') << endl;
 }
@@ -506,29 +1116,34 @@ void Pizzeria::printStatistics() {
 // Replace the printCompletionAnalysis method:
 
 void Pizzeria::printCompletionAnalysis() {
-    lock_guard<mutex> lock(cout_mutex);
+    lock_guard<ProfiledMutex> lock(cout_mutex);
     cout << "\n" << string(50, '=') << endl;
     cout << "COMPLETION ANALYSIS" << endl;
     cout << string(50, '=') << endl;
     
-    int unprocessed_orders = total_orders_placed - total_orders_delivered;
-    double completion_rate = (total_orders_delivered * 100.0) / total_orders_placed;
+    // Cancelled orders are neither completed nor failed
+    int unprocessed_orders = total_orders_placed - total_orders_delivered - total_orders_cancelled;
+    int expected_orders = total_orders_placed - total_orders_cancelled;
+    double completion_rate = expected_orders > 0 ? (total_orders_delivered * 100.0) / expected_orders : 100.0;
     
     cout << "Orders Placed: " << total_orders_placed << endl;
     cout << "Orders Delivered: " << total_orders_delivered << endl;
+    if (total_orders_cancelled > 0) {
+        cout << "Orders Cancelled: " << total_orders_cancelled << endl;
+    }
     cout << "Unprocessed Orders: " << unprocessed_orders << endl;
     cout << "Completion Rate: " << fixed << setprecision(1) << completion_rate << "%" << endl;
     
     {
-        lock_guard<mutex> order_lock(order_queue_mutex);
-        lock_guard<mutex> ready_lock(ready_orders_mutex);
+        lock_guard<ProfiledMutex> order_lock(order_queue_mutex);
+        lock_guard<ProfiledMutex> ready_lock(ready_orders_mutex);
         
-        if (!order_queue.empty()) {
-            cout << "WARNING: Orders still in queue: " << order_queue.size() << endl;
+        if (order_queue.size() > cancelled_queued) {
+            cout << "WARNING: Orders still in queue: " << order_queue.size() - cancelled_queued << endl;
         }
         
-        if (!ready_orders.empty()) {
-            cout << "WARNING: Orders ready but not delivered: " << ready_orders.size() << endl;
+        if (ready_orders.size() > cancelled_ready) {
+            cout << "WARNING: Orders ready but not delivered: " << ready_orders.size() - cancelled_ready << endl;
         }
     }
     
@@ -544,30 +1159,45 @@ void Pizzeria::printCompletionAnalysis() {
 }
 
 double Pizzeria::calculateRefund(double original_price) {
-    return original_price * 1.10; // 110% refund (original + 10% apology)
+    return original_price * LATE_REFUND_RATE; // 110% refund (original + 10% apology)
+}
+
+double Pizzeria::calculateCancellationRefund(double original_price) {
+    return original_price * CANCELLATION_REFUND_RATE; // customer's choice: 10% cancellation fee
 }
 
 // Replace the processRefunds method:
 
 void Pizzeria::processRefunds() {
+    // Refunded orders leave the queues before the ledger shows them
+    lock_guard<ProfiledMutex> checkpoint(checkpoint_mutex);
     vector<shared_ptr<Order>> undelivered_orders;
     
     // Collect undelivered orders from queue
     {
-        lock_guard<mutex> order_lock(order_queue_mutex);
-        while (!order_queue.empty()) {
-            undelivered_orders.push_back(order_queue.front());
-            order_queue.pop();
+        lock_guard<ProfiledMutex> order_lock(order_queue_mutex);
+        // Tombstones were refunded when they were cancelled
+        for (auto& order : order_queue) {
+            if (order->getLocation() != OrderLocation::CANCELLED) {
+                order->setLocation(OrderLocation::NONE);
+                undelivered_orders.push_back(move(order));
+            }
         }
+        order_queue.clear();
+        cancelled_queued = 0;
     }
     
     // Collect undelivered ready orders
     {
-        lock_guard<mutex> ready_lock(ready_orders_mutex);
-        while (!ready_orders.empty()) {
-            undelivered_orders.push_back(ready_orders.front());
-            ready_orders.pop();
+        lock_guard<ProfiledMutex> ready_lock(ready_orders_mutex);
+        for (auto& order : ready_orders) {
+            if (order->getLocation() != OrderLocation::CANCELLED) {
+                order->setLocation(OrderLocation::NONE);
+                undelivered_orders.push_back(move(order));
+            }
         }
+        ready_orders.clear();
+        cancelled_ready = 0;
     }
     
     // Process refunds
@@ -576,38 +1206,62 @@ void Pizzeria::processRefunds() {
         
         for (auto& order : undelivered_orders) {
             if (order->isPaid() && !order->isRefunded()) {
+                AllocationScope stage(AllocationStage::REFUND);
                 double refund_amount = calculateRefund(order->getPrice());
                 total_refunds.store(total_refunds.load() + refund_amount);
                 order->setRefunded(true);
+                recordHistory(*order);
+                g_metrics.increment(MetricCounter::ORDERS_REFUNDED);
+                if (g_tracer.isEnabled()) {
+                    // The order's last stage ends with the refund
+                    traceOrderStage(*order, order->getStatus(), order->getStageStart(), g_sim_clock.now());
+                }
+                if (order->getOrigin() != 0 && order_server) {
+                    order_server->notifyOrderEvent(*order, OrderEventType::REFUNDED);
+                }
                 
-                printOrderStatus("REFUND: Issued to Customer " + 
-                    to_string(order->getCustomerId()) + " for Order #" + 
-                    to_string(order->getOrderId()) + ": $" + 
-                    to_string(refund_amount).substr(0, to_string(refund_amount).find('.') + 3) + 
-                    " (Original: $" + to_string(order->getPrice()).substr(0, to_string(order->getPrice()).find('.') + 3) + 
-                    " + 10% apology)");
+                AllocationScope message(AllocationStage::STATUS_LINE);
+                StatusLine line;
+                line << "REFUND: Issued to Customer " << order->getCustomerId() << " for Order #"
+                     << order->getOrderId() << ": $" << Dollars{refund_amount} << " (Original: $"
+                     << Dollars{order->getPrice()} << " + 10% apology)";
+                printOrderStatus(line.view());
             }
         }
     }
 }
 
 void Pizzeria::printEarningsReport() {
-    lock_guard<mutex> lock(cout_mutex);
+    lock_guard<ProfiledMutex> lock(cout_mutex);
     cout << "\n" << string(60, '=') << endl;
     cout << "FINAL EARNINGS REPORT" << endl;  // Fixed: Removed Unicode money symbol
     cout << string(60, '=') << endl;
     
     double gross_earnings = total_earnings.load();
     double total_refunds_paid = total_refunds.load();
-    double net_earnings = gross_earnings - total_refunds_paid;
+    // A cancelled order's payment never reached gross earnings; the shop
+    // only keeps its fee
+    double fees_kept = cancellation_fees.load();
+    double net_earnings = gross_earnings + fees_kept - total_refunds_paid;
+    int cancellation_percent = static_cast<int>(lround(CANCELLATION_REFUND_RATE * 100));
     
     cout << "Gross Earnings (Delivered Orders): $" << fixed << setprecision(2) << gross_earnings << endl;
+    if (total_orders_cancelled > 0) {
+        cout << "Cancellation Fees Kept: $" << fixed << setprecision(2) << fees_kept << endl;
+    }
     cout << "Total Refunds Paid (with 10% apology): $" << fixed << setprecision(2) << total_refunds_paid << endl;
+    if (total_orders_cancelled > 0) {
+        cout << "Cancellation Refunds Paid (" << cancellation_percent << "% back): $" << fixed << setprecision(2)
+             << cancellation_refunds.load() << endl;
+    }
     cout << "Net Earnings: $" << fixed << setprecision(2) << net_earnings << endl;
     
     cout << "\nBREAKDOWN:" << endl;  // Fixed: Removed Unicode chart symbol
     cout << "  Orders Delivered: " << total_orders_delivered << endl;
     cout << "  Orders Refunded: " << (total_orders_placed - total_orders_delivered) << endl;
+    if (total_orders_cancelled > 0) {
+        cout << "    cancelled by customers (" << cancellation_percent << "% back): " << total_orders_cancelled << endl;
+    }
     cout << "  Average Order Value: $" << fixed << setprecision(2) 
          << (total_orders_delivered > 0 ? gross_earnings / total_orders_delivered : 0.0) << endl;
     
@@ -618,6 +1272,33 @@ void Pizzeria::printEarningsReport() {
     } else {
         cout << "\nBREAK-EVEN: Break-even day!" << endl;  // Fixed: Removed Unicode neutral face
     }
+
+    // Per-pizza breakdown from the order history, best sellers first
+    auto by_item = history.aggregate(HistoryGroupBy::MENU_ITEM);
+    vector<size_t> items;
+    for (size_t i = 0; i < by_item.size(); ++i) {
+        if (by_item[i].orders > 0) {
+            items.push_back(i);
+        }
+    }
+    sort(items.begin(), items.end(), [&](size_t a, size_t b) {
+        return by_item[a].revenue_cents != by_item[b].revenue_cents
+            ? by_item[a].revenue_cents > by_item[b].revenue_cents : a < b;
+    });
+    if (!items.empty()) {
+        cout << "\nBY PIZZA" << (items.size() > 10 ? " (top 10 by revenue)" : "") << ":" << endl;
+        for (size_t k = 0; k < min<size_t>(items.size(), 10); ++k) {
+            const HistoryAggregate& item = by_item[items[k]];
+            cout << "  " << setfill(' ') << left << setw(16) << catalog.getItemName(static_cast<MenuItemId>(items[k])) << right
+                 << setw(3) << item.delivered << " delivered  $" << fixed << setprecision(2) << setw(7)
+                 << item.revenue_cents / 100.0 << "  avg " << setprecision(1)
+                 << item.averageDeliveredMs() / 1000.0 << "s to door";
+            if (item.refunded > 0) {
+                cout << "  (" << item.refunded << " refunded)";
+            }
+            cout << endl;
+        }
+    }
     
     cout << string(60, '=') << endl;
 }
@@ -625,148 +1306,305 @@ void Pizzeria::printEarningsReport() {
 // Replace the deliveryService method:
 
 void Pizzeria::deliveryService() {
-    random_device rd;
-    mt19937 gen(rd());
-    uniform_int_distribution<> delivery_time(800, 2500);
+    SimRandom rng(simStream(SimStreamKind::DELIVERY));
+    
+    if (g_tracer.isEnabled()) {
+        g_tracer.setThreadName("Delivery");
+    }
     
     while (is_open || !ready_orders.empty()) {
         auto order = getReadyOrder();
         if (!order) {
             if (!is_open) {
-                lock_guard<mutex> lock(ready_orders_mutex);
+                lock_guard<ProfiledMutex> lock(ready_orders_mutex);
                 if (ready_orders.empty()) break;
             }
-            this_thread::sleep_for(chrono::milliseconds(50));
-            continue;
+            continue; // getReadyOrder already waited up to a second
         }
         
+        setOrderStatus(order, OrderStatus::OUT_FOR_DELIVERY);
+
         // Simulate delivery time
-        this_thread::sleep_for(chrono::milliseconds(delivery_time(gen)));
+        g_sim_clock.sleepFor(chrono::milliseconds(rng.uniformInt(DELIVERY_TIME_MS)));
         
-        order->setStatus(OrderStatus::DELIVERED);
-        order->markCompleted();
-        total_orders_delivered++;
+        AllocationScope stage(AllocationStage::DELIVER);
+        auto now = g_sim_clock.now();
+        order->markCompleted(now);
+        setOrderStatus(order, OrderStatus::DELIVERED, now);
+        settleDelivery(order);
+        shutdown.signal();
+        g_metrics.increment(MetricCounter::ORDERS_DELIVERED);
+        g_metrics.recordLatency(MetricHistogram::READY_TO_DELIVERED,
+            order->getCompletionTime() - order->getReadyTime());
+        g_metrics.recordLatency(MetricHistogram::ORDER_TO_DELIVERED,
+            order->getCompletionTime() - order->getOrderTime());
         
-        // Add to earnings when delivered
+        AllocationScope message(AllocationStage::STATUS_LINE);
+        StatusLine line;
+        line << "DELIVERY: Order #" << order->getOrderId() << " delivered to Customer " << order->getCustomerId()
+             << " ($" << Dollars{order->getPrice()} << ") - Processing time: " << Decimal{order->getProcessingTime()}
+             << "s";
+        printOrderStatus(line.view());
+    }
+}
+
+bool Pizzeria::isOpen() const {
+    return is_open.load();
+}
+
+bool Pizzeria::isAcceptingOrders() const {
+    return accepting_orders.load();
+}
+
+void Pizzeria::settleDelivery(const shared_ptr<Order>& order) {
+    {
+        // Leaves the delivery set and enters the ledger in one step, so a
+        // snapshot sees it either in flight or paid for
+        lock_guard<ProfiledMutex> lock(ready_orders_mutex);
+        eraseOrder(delivery_orders, order);
+        order->setLocation(OrderLocation::NONE);
+        total_orders_delivered++;
         if (order->isPaid()) {
             total_earnings.store(total_earnings.load() + order->getPrice());
         }
-        
-        printOrderStatus("DELIVERY: Order #" + to_string(order->getOrderId()) + 
-            " delivered to Customer " + to_string(order->getCustomerId()) + 
-            " ($" + to_string(order->getPrice()).substr(0, to_string(order->getPrice()).find('.') + 3) + 
-            ") - Processing time: " + to_string(order->getProcessingTime()) + "s");
     }
+    recordHistory(*order);
 }
 
-// Utility functions
-string pizzaTypeToString(PizzaType type) {
-    switch (type) {
-        case PizzaType::MARGHERITA: return "Margherita";
-        case PizzaType::PEPPERONI: return "Pepperoni";
-        case PizzaType::MUSHROOM: return "Mushroom";
-        case PizzaType::VEGGIE: return "Veggie";
-        case PizzaType::SUPREME: return "Supreme";
-        default: return "Unknown";
+// Finished orders leave the live index and move to the history
+void Pizzeria::recordHistory(const Order& order) {
+    order_index.remove(static_cast<uint32_t>(order.getOrderId()));
+    bool delivered = order.getStatus() == OrderStatus::DELIVERED;
+    // One row per pizza, so per-item reports see every line item
+    bool multi_item = order.getItemCount() > 1;
+    for (size_t i = 0; i < order.getItemCount(); ++i) {
+        MenuItemId item = order.getItem(i);
+        double price = multi_item ? catalog.getItemPrice(item) : order.getPrice();
+        history.append(static_cast<uint32_t>(order.getOrderId()), static_cast<uint16_t>(order.getCustomerId()),
+            item, priceToCents(price), order.getOrderTime(), order.getReadyTime(),
+            delivered ? order.getCompletionTime() : chrono::steady_clock::time_point{}, order.isRefunded());
     }
 }
 
-string orderStatusToString(OrderStatus status) {
-    switch (status) {
-        case OrderStatus::PENDING: return "Pending";
-        case OrderStatus::PREPARING: return "Preparing";
-        case OrderStatus::COOKING: return "Cooking";
-        case OrderStatus::READY: return "Ready";
-        case OrderStatus::DELIVERED: return "Delivered";
-        default: return "Unknown";
-    }
+optional<OrderStatus> Pizzeria::findOrderStatus(int order_id) {
+    auto status = order_index.lookup(static_cast<uint32_t>(order_id));
+    return status ? optional<OrderStatus>(static_cast<OrderStatus>(*status)) : nullopt;
 }
 
-string ingredientTypeToString(IngredientType type) {
-    switch (type) {
-        case IngredientType::DOUGH: return "Dough";
-        case IngredientType::CHEESE: return "Cheese";
-        case IngredientType::TOMATO_SAUCE: return "Tomato Sauce";
-        case IngredientType::PEPPERONI: return "Pepperoni";
-        case IngredientType::MUSHROOMS: return "Mushrooms";
-        case IngredientType::OLIVES: return "Olives";
-        case IngredientType::BELL_PEPPERS: return "Bell Peppers";
-        default: return "Unknown";
+void Pizzeria::customerFinished() {
+    active_customers--;
+    shutdown.signal();
+}
+
+SnapshotStats Pizzeria::writeSnapshot(const string& path) {
+    lock_guard<ProfiledMutex> checkpoint(checkpoint_mutex);
+    auto start = chrono::steady_clock::now();
+    SnapshotStats stats;
+    SnapshotHeader header{};
+    vector<int32_t> stock(inventory.size());
+    vector<shared_ptr<Order>> kitchen, queued, delivering, ready;
+    {
+        // Dispatch reserves stock under order_queue_mutex and every hand-off
+        // between queues, chefs and the driver happens under one of the two
+        // locks, so holding both gives a consistent cut
+        lock_guard<ProfiledMutex> order_lock(order_queue_mutex);
+        lock_guard<ProfiledMutex> ready_lock(ready_orders_mutex);
+        auto locked = chrono::steady_clock::now();
+        for (size_t i = 0; i < stock.size(); ++i) {
+            stock[i] = inventory.getQuantity(static_cast<IngredientId>(i));
+        }
+        auto live = [](const shared_ptr<Order>& order) {
+            return order->getLocation() != OrderLocation::CANCELLED;
+        };
+        kitchen = kitchen_orders;
+        queued.reserve(order_queue.size() - cancelled_queued);
+        copy_if(order_queue.begin(), order_queue.end(), back_inserter(queued), live);
+        delivering = delivery_orders;
+        ready.reserve(ready_orders.size() - cancelled_ready);
+        copy_if(ready_orders.begin(), ready_orders.end(), back_inserter(ready), live);
+        header.next_order_id = Order::order_counter.load();
+        header.orders_placed = total_orders_placed.load();
+        header.orders_completed = total_orders_completed.load();
+        header.orders_delivered = total_orders_delivered.load();
+        header.orders_cancelled = total_orders_cancelled.load();
+        header.kitchen_cancellations = kitchen_cancellations.load();
+        header.total_earnings = total_earnings.load();
+        header.total_refunds = total_refunds.load();
+        header.cancellation_refunds = cancellation_refunds.load();
+        header.cancellation_fees = cancellation_fees.load();
+        stats.pause = chrono::steady_clock::now() - locked;
+    }
+
+    // Kitchen orders will be cooked again after a restore, so the
+    // ingredients reserved for them go back into the snapshot's stock
+    for (const auto& order : kitchen) {
+        for (size_t n = 0; n < order->getItemCount(); ++n) {
+            MenuItemId item = order->getItem(n);
+            const IngredientId* ingredients = catalog.getRecipeIngredients(item);
+            const uint16_t* quantities = catalog.getRecipeQuantities(item);
+            for (size_t i = 0; i < catalog.getRecipeSize(item); ++i) {
+                stock[ingredients[i]] += quantities[i];
+            }
+        }
     }
+    auto byId = [](const shared_ptr<Order>& a, const shared_ptr<Order>& b) {
+        return a->getOrderId() < b->getOrderId();
+    };
+    sort(kitchen.begin(), kitchen.end(), byId);
+    sort(delivering.begin(), delivering.end(), byId);
+
+    auto now = g_sim_clock.now();
+    auto millisSince = [&now](chrono::steady_clock::time_point time) {
+        auto ms = chrono::duration_cast<chrono::milliseconds>(now - time).count();
+        return static_cast<uint32_t>(clamp<int64_t>(ms, 0, SNAPSHOT_NO_TIME - 1));
+    };
+    vector<SnapshotOrder> records;
+    records.reserve(kitchen.size() + queued.size() + delivering.size() + ready.size());
+    auto add = [&](const vector<shared_ptr<Order>>& orders, SnapshotOrderLocation location) {
+        for (const auto& order : orders) {
+            SnapshotOrder record{};
+            record.order_id = order->getOrderId();
+            record.customer_id = order->getCustomerId();
+            record.price = order->getPrice();
+            record.age_ms = millisSince(order->getOrderTime());
+            record.ready_age_ms = location == SnapshotOrderLocation::READY_QUEUE
+                ? millisSince(order->getReadyTime()) : SNAPSHOT_NO_TIME;
+            record.item_count = static_cast<uint8_t>(order->getItemCount());
+            copy(order->getItems(), order->getItems() + order->getItemCount(), record.items);
+            record.location = location;
+            record.paid = order->isPaid() ? 1 : 0;
+            records.push_back(record);
+        }
+    };
+    // Restore order: whatever was dispatched first goes back first
+    add(kitchen, SnapshotOrderLocation::ORDER_QUEUE);
+    add(queued, SnapshotOrderLocation::ORDER_QUEUE);
+    add(delivering, SnapshotOrderLocation::READY_QUEUE);
+    add(ready, SnapshotOrderLocation::READY_QUEUE);
+
+    header.item_count = static_cast<uint32_t>(catalog.getItemCount());
+    header.catalog_fingerprint = catalogFingerprint(catalog);
+    header.taken_at_unix_ms = chrono::duration_cast<chrono::milliseconds>(
+        chrono::system_clock::now().time_since_epoch()).count();
+    stats.bytes = writeSnapshotFile(path, header, stock, records);
+    stats.orders = records.size();
+    stats.elapsed = chrono::steady_clock::now() - start;
+    return stats;
 }
 
-// ingredients each pizza needs:
-vector<IngredientType> getRequiredIngredients(PizzaType pizza_type) {
-    vector<IngredientType> ingredients;
-    
-    // All pizzas need dough, cheese, and tomato sauce
-    ingredients.push_back(IngredientType::DOUGH);
-    ingredients.push_back(IngredientType::CHEESE);
-    ingredients.push_back(IngredientType::TOMATO_SAUCE);
-    
-    switch (pizza_type) {
-        case PizzaType::MARGHERITA:
-            // Only basic ingredients
-            break;
-        case PizzaType::PEPPERONI:
-            ingredients.push_back(IngredientType::PEPPERONI);
-            break;
-        case PizzaType::MUSHROOM:
-            ingredients.push_back(IngredientType::MUSHROOMS);
-            break;
-        case PizzaType::VEGGIE:
-            ingredients.push_back(IngredientType::MUSHROOMS);
-            ingredients.push_back(IngredientType::OLIVES);
-            ingredients.push_back(IngredientType::BELL_PEPPERS);
-            break;
-        case PizzaType::SUPREME:
-            ingredients.push_back(IngredientType::PEPPERONI);
-            ingredients.push_back(IngredientType::MUSHROOMS);
-            ingredients.push_back(IngredientType::OLIVES);
-            ingredients.push_back(IngredientType::BELL_PEPPERS);
-            break;
+SnapshotStats Pizzeria::restoreSnapshot(const string& path) {
+    auto start = chrono::steady_clock::now();
+    MappedSnapshot snapshot(path);
+    const SnapshotHeader& header = snapshot.getHeader();
+    if (header.ingredient_count != catalog.getIngredientCount() || header.item_count != catalog.getItemCount() ||
+        header.catalog_fingerprint != catalogFingerprint(catalog)) {
+        throw runtime_error("snapshot: " + path + " was taken with a different menu");
     }
-    
-    return ingredients;
+
+    const int32_t* stock = snapshot.getStock();
+    for (size_t i = 0; i < inventory.size(); ++i) {
+        auto ingredient = static_cast<IngredientId>(i);
+        inventory.restock(ingredient, stock[i] - inventory.getQuantity(ingredient));
+    }
+
+    auto now = g_sim_clock.now();
+    lock_guard<ProfiledMutex> order_lock(order_queue_mutex);
+    lock_guard<ProfiledMutex> ready_lock(ready_orders_mutex);
+    const SnapshotOrder* records = snapshot.getOrders();
+    for (size_t i = 0; i < snapshot.getOrderCount(); ++i) {
+        const SnapshotOrder& record = records[i];
+        bool valid = record.item_count >= 1 && record.item_count <= MAX_ORDER_ITEMS &&
+                     all_of(record.items, record.items + record.item_count,
+                            [this](MenuItemId item) { return item < catalog.getItemCount(); });
+        if (!valid) {
+            throw runtime_error("snapshot: " + path + ": order #" + to_string(record.order_id) +
+                                " has an unknown menu item");
+        }
+        bool ready = record.location == SnapshotOrderLocation::READY_QUEUE;
+        auto ready_time = ready && record.ready_age_ms != SNAPSHOT_NO_TIME
+            ? now - chrono::milliseconds(record.ready_age_ms) : chrono::steady_clock::time_point{};
+        auto order = make_shared<Order>(record.order_id, record.customer_id, record.items, record.item_count,
+                                        record.price, now - chrono::milliseconds(record.age_ms), ready_time);
+        order->setPaid(record.paid != 0);
+        OrderStatus status = ready ? OrderStatus::READY : OrderStatus::PENDING;
+        order->setStatus(status);
+        order_index.insert(static_cast<uint32_t>(record.order_id), static_cast<uint8_t>(status));
+        order->setLocation(ready ? OrderLocation::READY_QUEUE : OrderLocation::ORDER_QUEUE);
+        (ready ? ready_orders : order_queue).push_back(move(order));
+    }
+
+    // New orders continue after the restored ids
+    int next_id = Order::order_counter.load();
+    while (next_id < header.next_order_id && !Order::order_counter.compare_exchange_weak(next_id, header.next_order_id)) {
+    }
+    total_orders_placed = header.orders_placed;
+    total_orders_completed = header.orders_completed;
+    total_orders_delivered = header.orders_delivered;
+    total_orders_cancelled = header.orders_cancelled;
+    kitchen_cancellations = header.kitchen_cancellations;
+    total_earnings.store(header.total_earnings);
+    total_refunds.store(header.total_refunds);
+    cancellation_refunds.store(header.cancellation_refunds);
+    cancellation_fees.store(header.cancellation_fees);
+    g_metrics.setGauge(MetricGauge::ORDER_QUEUE_DEPTH, order_queue.size());
+    g_metrics.setGauge(MetricGauge::READY_QUEUE_DEPTH, ready_orders.size());
+
+    SnapshotStats stats;
+    stats.orders = snapshot.getOrderCount();
+    stats.bytes = snapshot.getSize();
+    stats.elapsed = chrono::steady_clock::now() - start;
+    return stats;
 }
 
-bool Pizzeria::isOpen() const {
-    return is_open.load();
+void Pizzeria::enableCheckpoints(const string& path, chrono::milliseconds interval) {
+    checkpoint_path = path;
+    checkpoint_interval = interval;
 }
 
-bool Pizzeria::isAcceptingOrders() const {
-    return accepting_orders.load();
+void Pizzeria::writeCheckpoint() {
+    try {
+        last_checkpoint = writeSnapshot(checkpoint_path);
+        checkpoints_written++;
+        longest_checkpoint_pause = max(longest_checkpoint_pause, last_checkpoint.pause);
+    } catch (const exception& e) {
+        printOrderStatus(string("CHECKPOINT: ") + e.what());
+    }
+}
+
+void Pizzeria::checkpointService() {
+    // Refunds at closing take the queues apart; the final checkpoint is
+    // written once they are settled
+    while (!shutdown.sleepUnless(ShutdownPhase::DELIVERY_DRAINED, checkpoint_interval)) {
+        writeCheckpoint();
+    }
 }
 
 void Pizzeria::ingredientManager() {
-    uniform_int_distribution<> restock_amount(5, 20);
-    
-    while (is_open) {
-        this_thread::sleep_for(chrono::seconds(8)); // Check every 8 seconds
+    while (!shutdown.sleepUnless(ShutdownPhase::CLOSED, RESTOCK_INTERVAL)) {
         
         // Check if any ingredient is running low
         bool need_restock = false;
-        for (const auto& ingredient : ingredients) {
-            if (ingredient->getQuantity() < 10) { // Restock when below 10 units
+        for (size_t i = 0; i < inventory.size(); ++i) {
+            if (inventory.getQuantity(static_cast<IngredientId>(i)) < RESTOCK_THRESHOLD) {
                 need_restock = true;
                 break;
             }
         }
         
         if (need_restock) {
-            for (auto& ingredient : ingredients) {
-                ingredient->restock(restock_amount(gen));
+            for (size_t i = 0; i < inventory.size(); ++i) {
+                inventory.restock(static_cast<IngredientId>(i), restock_rng.uniformInt(RESTOCK_AMOUNT));
             }
+            g_metrics.increment(MetricCounter::RESTOCKS);
             printOrderStatus("RESTOCK: Ingredients restocked!"); // Fixed: Removed Unicode box symbol
+            // Orders blocked on stock may be makeable now
+            order_available.notify_all();
         }
     }
 }
 
 void Pizzeria::statisticsReporter() {
-    while (is_open) {
-        this_thread::sleep_for(chrono::seconds(15)); // Report every 15 seconds
-        if (is_open) {
-            printStatistics();
-        }
+    while (!shutdown.sleepUnless(ShutdownPhase::CLOSED, chrono::seconds(15))) { // Report every 15 seconds
+        printStatistics();
     }
 }
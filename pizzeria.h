@@ -1,6 +1,20 @@
 #pragma once
 #include <bits/stdc++.h>
 #include <semaphore>
+#include "alloc_tracker.h"
+#include "availability.h"
+#include "catalog.h"
+#include "lock_profiler.h"
+#include "metrics.h"
+#include "order_history.h"
+#include "order_index.h"
+#include "order_server.h"
+#include "placement.h"
+#include "shutdown.h"
+#include "simulation.h"
+#include "snapshot.h"
+#include "status_line.h"
+#include "tracer.h"
 
 using namespace std;
 
@@ -8,26 +22,58 @@ using namespace std;
 class Order;
 class Chef;
 class Customer;
-class Ingredient;
+
+// Ingredient table: X(enum name, display name, initial stock)
+#define PIZZERIA_INGREDIENTS(X)                  \
+    X(DOUGH,        "Dough",        5)           \
+    X(CHEESE,       "Cheese",       10)          \
+    X(TOMATO_SAUCE, "Tomato Sauce", 8)           \
+    X(PEPPERONI,    "Pepperoni",    6)           \
+    X(MUSHROOMS,    "Mushrooms",    4)           \
+    X(OLIVES,       "Olives",       3)           \
+    X(BELL_PEPPERS, "Bell Peppers", 3)
 
 // Ingredient types
 enum class IngredientType {
-    DOUGH,
-    CHEESE,
-    TOMATO_SAUCE,
-    PEPPERONI,
-    MUSHROOMS,
-    OLIVES,
-    BELL_PEPPERS
+#define X(id, name, stock) id,
+    PIZZERIA_INGREDIENTS(X)
+#undef X
 };
 
+// Recipes are bitmasks over IngredientType
+using IngredientMask = uint32_t;
+
+constexpr IngredientMask ingredientBit(IngredientType type) {
+    return IngredientMask{1} << static_cast<int>(type);
+}
+
+constexpr IngredientMask BASE_INGREDIENTS = ingredientBit(IngredientType::DOUGH) |
+                                            ingredientBit(IngredientType::CHEESE) |
+                                            ingredientBit(IngredientType::TOMATO_SAUCE);
+
+// Menu table: X(enum name, display name, price, recipe). Adding a pizza means
+// adding one row here; the enum, prices, names and recipes all derive from it.
+#define PIZZERIA_MENU(X)                                                          \
+    X(MARGHERITA, "Margherita", 12.99, BASE_INGREDIENTS)                          \
+    X(PEPPERONI,  "Pepperoni",  15.99, BASE_INGREDIENTS |                         \
+                                       ingredientBit(IngredientType::PEPPERONI))  \
+    X(MUSHROOM,   "Mushroom",   14.99, BASE_INGREDIENTS |                         \
+                                       ingredientBit(IngredientType::MUSHROOMS))  \
+    X(VEGGIE,     "Veggie",     16.99, BASE_INGREDIENTS |                         \
+                                       ingredientBit(IngredientType::MUSHROOMS) | \
+                                       ingredientBit(IngredientType::OLIVES) |    \
+                                       ingredientBit(IngredientType::BELL_PEPPERS)) \
+    X(SUPREME,    "Supreme",    19.99, BASE_INGREDIENTS |                         \
+                                       ingredientBit(IngredientType::PEPPERONI) | \
+                                       ingredientBit(IngredientType::MUSHROOMS) | \
+                                       ingredientBit(IngredientType::OLIVES) |    \
+                                       ingredientBit(IngredientType::BELL_PEPPERS))
+
 // Pizza types
 enum class PizzaType {
-    MARGHERITA,
-    PEPPERONI,
-    MUSHROOM,
-    VEGGIE,
-    SUPREME
+#define X(id, name, price, recipe) id,
+    PIZZERIA_MENU(X)
+#undef X
 };
 
 // Order status
@@ -36,24 +82,79 @@ enum class OrderStatus {
     PREPARING,
     COOKING,
     READY,
+    OUT_FOR_DELIVERY,
     DELIVERED
 };
 
-// Ingredient class
-class Ingredient {
-private:
-    IngredientType type;
-    string name;
-    int quantity;
-    mutable mutex ingredient_mutex;
+// Which pizzeria collection holds an order. Changed only under the lock of
+// the collection it enters or leaves; cancelOrder holds both queue locks.
+enum class OrderLocation : uint8_t {
+    NONE,          // not queued yet, or settled
+    ORDER_QUEUE,   // queued, possibly waiting for ingredients
+    KITCHEN,       // dispatched to a chef, ingredients reserved
+    READY_QUEUE,
+    DELIVERY,      // with the driver
+    CANCELLED      // tombstone: skipped by dispatch and delivery, purged lazily
+};
 
-public:
-    Ingredient(IngredientType t, const string& n, int q);
-    bool consume(int amount);
-    void restock(int amount);
-    int getQuantity() const;
-    string getName() const;
-    IngredientType getType() const;
+struct IngredientInfo {
+    string_view name;
+    int initial_stock;
+};
+
+struct PizzaInfo {
+    string_view name;
+    double price;
+    IngredientMask recipe;
+};
+
+constexpr IngredientInfo INGREDIENT_TABLE[] = {
+#define X(id, name, stock) {name, stock},
+    PIZZERIA_INGREDIENTS(X)
+#undef X
+};
+
+constexpr PizzaInfo PIZZA_TABLE[] = {
+#define X(id, name, price, recipe) {name, price, recipe},
+    PIZZERIA_MENU(X)
+#undef X
+};
+
+constexpr int INGREDIENT_TYPE_COUNT = static_cast<int>(size(INGREDIENT_TABLE));
+constexpr int PIZZA_TYPE_COUNT = static_cast<int>(size(PIZZA_TABLE));
+
+static_assert(INGREDIENT_TYPE_COUNT <= 32, "IngredientMask holds at most 32 ingredients");
+
+constexpr string_view ORDER_STATUS_NAMES[] = {
+    "Pending", "Preparing", "Cooking", "Ready", "Out for Delivery", "Delivered"
+};
+
+// Workload of a simulated day. The actors draw from these ranges and the
+// queueing estimator (estimator.h) models the same distributions.
+constexpr UniformRange ORDERS_PER_CUSTOMER{1, 3};
+constexpr UniformRange ORDER_GAP_MS{2000, 8000};
+constexpr UniformRange FAMILY_EXTRA_ITEMS{1, 3};     // with --family-orders
+constexpr UniformRange COOK_TIME_MS{3000, 8000};
+constexpr int PREP_BASE_MS = 1000;                   // plus a quarter of a cooking-time draw
+constexpr UniformRange DELIVERY_TIME_MS{800, 2500};  // one driver
+constexpr UniformRange RESTOCK_AMOUNT{5, 20};        // per ingredient
+constexpr int RESTOCK_THRESHOLD = 10;                // restock everything once any ingredient is below
+constexpr chrono::seconds RESTOCK_INTERVAL{8};
+constexpr chrono::seconds INTAKE_WINDOW{25};
+constexpr chrono::seconds DRAIN_BUDGET{50};          // kitchen and delivery after intake stops
+constexpr double LATE_REFUND_RATE = 1.10;            // undelivered at close: price + 10% apology
+constexpr double CANCELLATION_REFUND_RATE = 0.90;    // cancelled by the customer: price - 10% fee
+
+// Fork/join progress of a dispatched order across chefs; guarded by the
+// pizzeria's order_queue_mutex
+static_assert(MAX_ORDER_ITEMS <= 8, "KitchenProgress::cooking has one bit per line item");
+
+struct KitchenProgress {
+    uint8_t claimed = 0;        // line items handed to a chef
+    uint8_t unfinished = 0;     // line items not cooked yet
+    uint8_t cooking = 0;        // bit per helper's item in the oven; its ingredients are spent
+    chrono::steady_clock::time_point dispatched;
+    chrono::nanoseconds work{0};  // preparation + cooking, summed over items
 };
 
 // Order class
@@ -61,29 +162,62 @@ class Order {
 private:
     const int order_id;
     const int customer_id;
-    const PizzaType pizza_type;
+    // Line items (pizzas), inline so placing an order stays one allocation
+    array<MenuItemId, MAX_ORDER_ITEMS> items;
+    uint8_t item_count;
     OrderStatus status;
     chrono::steady_clock::time_point order_time;
+    chrono::steady_clock::time_point ready_time;
     chrono::steady_clock::time_point completion_time;
-    mutable mutex order_mutex;
+    chrono::steady_clock::time_point stage_start;   // when the current status began
+    mutable ProfiledMutex order_mutex{"order"};
 
     // Add these pricing-related members:
     double price;
     bool is_paid;
     bool is_refunded;
+    bool is_cancelled;             // guarded by order_mutex, like status
+
+    // Guarded by the pizzeria's queue locks (see OrderLocation)
+    OrderLocation location;
+    KitchenProgress kitchen;
+
+    // Network origin (OrderServer connection token), 0 for in-process customers.
+    // Set once before the order is queued.
+    uint64_t origin;
+    uint32_t client_tag;
 
 public:
     static atomic<int> order_counter;
 
-    Order(int cust_id, PizzaType type);
+    Order(int cust_id, MenuItemId item);
+    // 1 to MAX_ORDER_ITEMS line items, priced together
+    Order(int cust_id, const MenuItemId* line_items, size_t count);
+    // Recreates an order from a snapshot, keeping its id and paid price;
+    // `ready` is a default time_point if the order was not ready yet
+    Order(int id, int cust_id, const MenuItemId* line_items, size_t count, double paid_price,
+          chrono::steady_clock::time_point placed, chrono::steady_clock::time_point ready);
     int getOrderId() const;
     int getCustomerId() const;
-    PizzaType getPizzaType() const;
+    MenuItemId getMenuItem() const;     // the first line item
+    size_t getItemCount() const;
+    MenuItemId getItem(size_t index) const;
+    const MenuItemId* getItems() const;
     OrderStatus getStatus() const;
-    void setStatus(OrderStatus new_status);
-    string getPizzaName() const;
+    // Status changes fail (return false / nullopt) once the order is cancelled
+    bool setStatus(OrderStatus new_status);
+    // Sets the status and stamps the stage start with `now` under one lock;
+    // returns the previous status and its start time (used by tracing)
+    optional<OrderStatus> advanceStatus(OrderStatus new_status, chrono::steady_clock::time_point now,
+                                        chrono::steady_clock::time_point& previous_start);
+    chrono::steady_clock::time_point getStageStart() const;
+    string_view getPizzaName() const;
     double getProcessingTime() const;
-    void markCompleted();
+    void markReady(chrono::steady_clock::time_point at);
+    void markCompleted(chrono::steady_clock::time_point at);
+    chrono::steady_clock::time_point getOrderTime() const;
+    chrono::steady_clock::time_point getReadyTime() const;
+    chrono::steady_clock::time_point getCompletionTime() const;
 
     // Add these pricing-related method declarations:
     double getPrice() const;
@@ -91,6 +225,30 @@ public:
     bool isPaid() const;
     void setRefunded(bool refunded);
     bool isRefunded() const;
+
+    // Cancels unless the order has already reached `limit`
+    bool cancelBefore(OrderStatus limit);
+    bool isCancelled() const;
+
+    // Caller holds the queue lock guarding the order's location
+    OrderLocation getLocation() const;
+    void setLocation(OrderLocation new_location);
+    // Caller holds the pizzeria's order_queue_mutex
+    KitchenProgress& getKitchenProgress();
+
+    void setOrigin(uint64_t origin_token, uint32_t tag);
+    uint64_t getOrigin() const;
+    uint32_t getClientTag() const;
+};
+
+// One line item of a dispatched order, as handed to a chef. Item 0 goes to
+// the chef that dispatched the order (the lead), who also moves the order
+// through its statuses and joins the other items.
+struct PrepTask {
+    shared_ptr<Order> order;
+    uint8_t item = 0;
+
+    explicit operator bool() const { return order != nullptr; }
 };
 
 // Chef class
@@ -100,6 +258,14 @@ private:
     string name;
     bool is_working;
     thread chef_thread;
+
+    // Prints "Chef N (name) <action> Order #id (pizza)" without allocating;
+    // multi-item orders also name the line item
+    void announce(string_view action, const Order& order, size_t item = 0) const;
+
+    // Prepares and cooks one line item; the lead also sets PREPARING and
+    // COOKING. False if the order was cancelled before cooking started.
+    bool makeItem(const PrepTask& task, SimRandom& rng, bool lead);
     
 public:
     Chef(int id, const string& chef_name);
@@ -108,7 +274,7 @@ public:
     void stopWorking();
     void work();
     int getChefId() const;
-    string getName() const;
+    const string& getName() const;
 };
 
 // Customer class
@@ -122,51 +288,116 @@ public:
     Customer(int id, const string& customer_name);
     ~Customer();
     void startOrdering();
+    // Joins the customer thread once it has placed its orders
+    void finishOrdering();
     void placeOrders();
     int getCustomerId() const;
-    string getName() const;
+    const string& getName() const;
 };
 
 // Pizzeria class - main orchestrator
 class Pizzeria {
 private:
     // Concurrency controls
-    mutex order_queue_mutex;
-    mutex ready_orders_mutex;
-    mutex cout_mutex;
-    condition_variable order_available;
-    condition_variable ready_order_available;
+    // Named for the lock-contention report (lock_profiler.h)
+    ProfiledMutex order_queue_mutex{"order_queue"};
+    ProfiledMutex ready_orders_mutex{"ready_orders"};
+    ProfiledMutex cout_mutex{"cout"};
+    ProfiledConditionVariable order_available{"order_available"};
+    ProfiledConditionVariable ready_order_available{"ready_available"};
+    ProfiledConditionVariable item_finished{"item_finished"};
     
     // Semaphores for resource management
     counting_semaphore<> chef_semaphore;
     counting_semaphore<> ingredient_semaphore;
     
     // Collections
-    queue<shared_ptr<Order>> order_queue;
-    queue<shared_ptr<Order>> ready_orders;
+    deque<shared_ptr<Order>> order_queue;
+    deque<shared_ptr<Order>> ready_orders;
+
+    // Multi-item orders in the kitchen with line items no chef has claimed
+    // yet, oldest first; guarded by order_queue_mutex
+    deque<shared_ptr<Order>> prep_tasks;
+    bool parallel_prep = true;
+
+    // Cancelled orders still sitting in each queue (tombstones), guarded by
+    // that queue's mutex; live depth is size() minus these
+    size_t cancelled_queued = 0;
+    size_t cancelled_ready = 0;
+
+    // Orders off a queue and in someone's hands: dispatched to a chef but not
+    // ready yet, or picked up for delivery but not settled. Snapshots need
+    // them; guarded by ready_orders_mutex.
+    vector<shared_ptr<Order>> kitchen_orders;
+    vector<shared_ptr<Order>> delivery_orders;
     vector<unique_ptr<Chef>> chefs;
     vector<unique_ptr<Customer>> customers;
-    vector<unique_ptr<Ingredient>> ingredients;
+
+    // Ingredient stock, indexed by the catalog's IngredientId
+    const MenuCatalog& catalog;
+    Inventory inventory;
+
+    // Dispatch scans the order queue for makeable orders; scratch buffers are
+    // guarded by order_queue_mutex
+    AvailabilityEngine availability;
+    vector<int32_t> dispatch_stock;
+    vector<int32_t> dispatch_counts;
+    bool ingredients_blocked = false;
     
     // Statistics
     atomic<int> total_orders_placed{0};
     atomic<int> total_orders_completed{0};
     atomic<int> total_orders_delivered{0};
+    atomic<int> total_orders_cancelled{0};
+    atomic<int> kitchen_cancellations{0}; // cancelled before ready; never completed
+
+    // Multi-item orders: time in the kitchen against the chef time they took
+    atomic<int> multi_item_orders{0};
+    atomic<int64_t> multi_item_kitchen_ns{0};
+    atomic<int64_t> multi_item_work_ns{0};
 
     // New statistics members
     atomic<double> total_earnings{0.0};
-    atomic<double> total_refunds{0.0};
-    map<PizzaType, double> pizza_prices;
+    atomic<double> total_refunds{0.0};          // late refunds, with the apology
+    atomic<double> cancellation_refunds{0.0};   // paid back to customers who cancelled
+    atomic<double> cancellation_fees{0.0};      // kept from cancelled orders' prices
+
+    // Live metrics published to shared memory for pizzeria_monitor
+    MetricsExporter metrics_exporter;
+
+    // Optional socket front end for external order traffic
+    unique_ptr<OrderServer> order_server;
     
+    // Chance that a customer cancels an order after placing it (0 = never)
+    int cancel_percent = 0;
+    // Chance that a customer's order has 2-4 pizzas instead of one
+    int family_percent = 0;
+
     // Control flags
     atomic<bool> is_open{true};
     atomic<bool> accepting_orders{true};
+
+    // Closing phases; waits end on completion signals instead of timers
+    ShutdownCoordinator shutdown;
+    atomic<int> active_customers{0};
     
-    // Random number generation
-    random_device rd;
-    mt19937 gen;
-    uniform_int_distribution<> pizza_dist;
-    uniform_int_distribution<> timing_dist;
+    // Restock amounts; a seeded stream of its own (see simulation.h)
+    SimRandom restock_rng;
+
+    // Every delivered or refunded order, for reporting
+    OrderHistory history;
+
+    // Status of every order not yet delivered or refunded, by order id
+    OrderIndex order_index;
+
+    // Periodic snapshots (disabled while checkpoint_path is empty).
+    // checkpoint_mutex keeps a snapshot from interleaving with refunds.
+    ProfiledMutex checkpoint_mutex{"checkpoint"};
+    string checkpoint_path;
+    chrono::milliseconds checkpoint_interval{5000};
+    int checkpoints_written = 0;
+    chrono::nanoseconds longest_checkpoint_pause{0};
+    SnapshotStats last_checkpoint;
     
 public:
     Pizzeria(int num_chefs, int num_customers);
@@ -174,29 +405,86 @@ public:
     
     // Order management
     void addOrder(shared_ptr<Order> order);
-    shared_ptr<Order> getNextOrder();
+    // Next line item for a chef: unclaimed items of orders already in the
+    // kitchen first, then item 0 of a newly dispatched order, whose whole
+    // recipe list is reserved at once. Empty while nothing can be made.
+    PrepTask getNextTask();
+    // Lead chef: claims another item of its own order nobody has started
+    PrepTask claimTask(const shared_ptr<Order>& order);
+    void finishItem(const PrepTask& task, chrono::nanoseconds work);
+    // Helper chef: puts an item in the oven unless its order was cancelled.
+    // A cancel returns the ingredients of every item not in an oven.
+    bool startCooking(const PrepTask& task);
+    // Lead chef: blocks until every item of the order is cooked
+    void awaitItems(const shared_ptr<Order>& order);
+    // Serial preparation: the lead chef makes every item itself
+    void setParallelPrep(bool enabled);
     void addReadyOrder(shared_ptr<Order> order);
     shared_ptr<Order> getReadyOrder();
+    // Books an order already marked DELIVERED: counters, ledger, history
+    void settleDelivery(const shared_ptr<Order>& order);
+    // False if the order was cancelled; its status is left unchanged
+    bool setOrderStatus(const shared_ptr<Order>& order, OrderStatus new_status);
+    // Same, tracing the transition at a clock reading the caller already took
+    bool setOrderStatus(const shared_ptr<Order>& order, OrderStatus new_status, chrono::steady_clock::time_point now);
+
+    // Takes an order back while it is queued (or waiting for ingredients), in
+    // the kitchen before cooking starts (its ingredients go back to stock) or
+    // on the ready shelf. O(1): the order is tombstoned in place. Returns the
+    // refund issued, or nullopt if the order is past cancelling.
+    optional<double> cancelOrder(const shared_ptr<Order>& order);
+    void enableCancellations(int percent);
+    int getCancelPercent() const { return cancel_percent; }
+    void enableFamilyOrders(int percent);
+    int getFamilyOrderPercent() const { return family_percent; }
+
+    // Accept orders over a local socket in addition to the customer threads
+    void enableOrderServer(const OrderServerEndpoint& endpoint);
     
     // Ingredient management
-    bool checkAndConsumeIngredients(PizzaType pizza_type);
+    bool checkAndConsumeIngredients(MenuItemId item);
+    size_t countMakeableQueuedOrders();
     void restockIngredients();
     
+    // Snapshot of inventory, queues, in-flight orders, counters and ledger.
+    // The queues are locked only while pointers and counters are copied.
+    // Throws runtime_error if the file cannot be written.
+    SnapshotStats writeSnapshot(const string& path);
+
+    // Call before startOperations(). Orders that were in the kitchen go back
+    // to the front of the order queue (their ingredients were credited back
+    // at snapshot time), orders out for delivery back to the ready queue.
+    // Throws runtime_error if the file is invalid or from a different menu.
+    SnapshotStats restoreSnapshot(const string& path);
+
+    // Snapshot to `path` every `interval` of simulated time while open
+    void enableCheckpoints(const string& path, chrono::milliseconds interval);
+
     // Threading methods
     void startOperations();
     void stopOperations();
     
     // Utility methods
-    void printOrderStatus(const string& message);
+    void printOrderStatus(string_view message);
     void printStatistics();
     bool isOpen() const;
     bool isAcceptingOrders() const;
+    ShutdownCoordinator& getShutdown() { return shutdown; }
+    OrderHistory& getHistory() { return history; }
+    const Inventory& getInventory() const { return inventory; }
+
+    // "Where is order #N?" without touching the queues; nullopt once the
+    // order is delivered or refunded (see getHistory) or if it never existed
+    optional<OrderStatus> findOrderStatus(int order_id);
+    void customerFinished();
 
     // New utility methods
-    void initializePrices();
     double calculateRefund(double original_price);
+    double calculateCancellationRefund(double original_price);
     void processRefunds();
     void printEarningsReport();
+    // Late refunds and cancellation refunds paid so far
+    double getTotalRefunds() const { return total_refunds.load(); }
     
     // Delivery thread
     void deliveryService();
@@ -206,16 +494,48 @@ public:
     
     // Statistics thread
     void statisticsReporter();
+
+    // Checkpoint thread (only with enableCheckpoints)
+    void checkpointService();
     
 private:
     void printCompletionAnalysis();
+    void recordHistory(const Order& order);
+    void writeCheckpoint();
+    shared_ptr<Order> takeMakeableOrder();
+    PrepTask forkOrder(const shared_ptr<Order>& order);
+    PrepTask claimQueuedTask();
 };
 
 // Global pizzeria instance
 extern unique_ptr<Pizzeria> g_pizzeria;
 
-// Utility functions
-string pizzaTypeToString(PizzaType type);
-string orderStatusToString(OrderStatus status);
-string ingredientTypeToString(IngredientType type);
-vector<IngredientType> getRequiredIngredients(PizzaType pizza_type);
+// Utility functions - table lookups, evaluated at compile time where possible
+constexpr string_view pizzaTypeToString(PizzaType type) {
+    int index = static_cast<int>(type);
+    return index >= 0 && index < PIZZA_TYPE_COUNT ? PIZZA_TABLE[index].name : "Unknown";
+}
+
+constexpr string_view orderStatusToString(OrderStatus status) {
+    int index = static_cast<int>(status);
+    return index >= 0 && index < static_cast<int>(size(ORDER_STATUS_NAMES)) ? ORDER_STATUS_NAMES[index] : "Unknown";
+}
+
+constexpr string_view ingredientTypeToString(IngredientType type) {
+    int index = static_cast<int>(type);
+    return index >= 0 && index < INGREDIENT_TYPE_COUNT ? INGREDIENT_TABLE[index].name : "Unknown";
+}
+
+constexpr double getPizzaPrice(PizzaType type) {
+    int index = static_cast<int>(type);
+    return index >= 0 && index < PIZZA_TYPE_COUNT ? PIZZA_TABLE[index].price : PIZZA_TABLE[0].price;
+}
+
+// ingredients each pizza needs, one bit per IngredientType
+constexpr IngredientMask getRequiredIngredients(PizzaType pizza_type) {
+    int index = static_cast<int>(pizza_type);
+    return index >= 0 && index < PIZZA_TYPE_COUNT ? PIZZA_TABLE[index].recipe : 0;
+}
+
+static_assert(getRequiredIngredients(PizzaType::MARGHERITA) == BASE_INGREDIENTS);
+static_assert(pizzaTypeToString(PizzaType::SUPREME) == "Supreme");
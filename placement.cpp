@@ -0,0 +1,316 @@
+#include <bits/stdc++.h>
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#elif defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+#include "placement.h"
+using namespace std;
+
+ThreadPlacer g_placement;
+
+bool parsePlacementPolicy(string_view name, PlacementPolicy& policy) {
+    for (size_t i = 0; i < size(PLACEMENT_POLICY_NAMES); ++i) {
+        if (name == PLACEMENT_POLICY_NAMES[i]) {
+            policy = static_cast<PlacementPolicy>(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+// CpuTopology implementation
+CpuTopology::CpuTopology(vector<CpuInfo> cpu_list) : cpus(move(cpu_list)) {
+    sort(cpus.begin(), cpus.end(), [](const CpuInfo& a, const CpuInfo& b) {
+        return tie(a.node, a.package, a.core, a.cpu) < tie(b.node, b.package, b.core, b.cpu);
+    });
+}
+
+// "0-3,8-11" -> 0 1 2 3 8 9 10 11
+static vector<int> parseCpuList(const string& text) {
+    vector<int> result;
+    stringstream ranges(text);
+    string range;
+    while (getline(ranges, range, ',')) {
+        int first = 0;
+        int last = 0;
+        int fields = sscanf(range.c_str(), "%d-%d", &first, &last);
+        if (fields < 1) {
+            continue;
+        }
+        for (int cpu = first; cpu <= (fields == 2 ? last : first); ++cpu) {
+            result.push_back(cpu);
+        }
+    }
+    return result;
+}
+
+static optional<int> readIntFile(const string& path) {
+    ifstream file(path);
+    int value = 0;
+    if (file >> value) {
+        return value;
+    }
+    return nullopt;
+}
+
+static vector<int> allowedCpus() {
+    vector<int> allowed;
+#if defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+        for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+            if (CPU_ISSET(cpu, &set)) {
+                allowed.push_back(cpu);
+            }
+        }
+    }
+#elif defined(_WIN32)
+    DWORD_PTR process_mask = 0;
+    DWORD_PTR system_mask = 0;
+    if (GetProcessAffinityMask(GetCurrentProcess(), &process_mask, &system_mask)) {
+        for (int cpu = 0; cpu < static_cast<int>(sizeof(DWORD_PTR) * 8); ++cpu) {
+            if (process_mask & (DWORD_PTR{1} << cpu)) {
+                allowed.push_back(cpu);
+            }
+        }
+    }
+#endif
+    if (allowed.empty()) {
+        for (unsigned cpu = 0; cpu < max(1u, thread::hardware_concurrency()); ++cpu) {
+            allowed.push_back(static_cast<int>(cpu));
+        }
+    }
+    return allowed;
+}
+
+// Package and core ids from /proc/cpuinfo, for kernels without sysfs topology
+static map<int, pair<int, int>> readProcCpuinfo() {
+    map<int, pair<int, int>> ids; // cpu -> {package, core}
+    ifstream file("/proc/cpuinfo");
+    string line;
+    int cpu = -1;
+    while (getline(file, line)) {
+        auto colon = line.find(':');
+        if (colon == string::npos) {
+            continue;
+        }
+        string key = line.substr(0, line.find_last_not_of(" \t", colon - 1) + 1);
+        int value = atoi(line.c_str() + colon + 1);
+        if (key == "processor") {
+            cpu = value;
+            ids[cpu] = {0, cpu};
+        } else if (cpu >= 0 && key == "physical id") {
+            ids[cpu].first = value;
+        } else if (cpu >= 0 && key == "core id") {
+            ids[cpu].second = value;
+        }
+    }
+    return ids;
+}
+
+CpuTopology CpuTopology::detect() {
+    const string cpu_root = "/sys/devices/system/cpu/cpu";
+    map<int, int> node_of;
+    error_code error;
+    for (const auto& entry : filesystem::directory_iterator("/sys/devices/system/node", error)) {
+        string name = entry.path().filename().string();
+        if (name.rfind("node", 0) == 0 && name.size() > 4 && isdigit(static_cast<unsigned char>(name[4]))) {
+            ifstream list(entry.path() / "cpulist");
+            string text;
+            getline(list, text);
+            for (int cpu : parseCpuList(text)) {
+                node_of[cpu] = atoi(name.c_str() + 4);
+            }
+        }
+    }
+    map<int, pair<int, int>> proc_ids;
+    bool proc_read = false;
+
+    vector<CpuInfo> cpus;
+    for (int cpu : allowedCpus()) {
+        CpuInfo info;
+        info.cpu = cpu;
+        info.core = cpu;
+        string topology_dir = cpu_root + to_string(cpu) + "/topology/";
+        auto core = readIntFile(topology_dir + "core_id");
+        auto package = readIntFile(topology_dir + "physical_package_id");
+        if (core && package) {
+            info.core = *core;
+            info.package = max(0, *package);
+        } else {
+            if (!proc_read) {
+                proc_ids = readProcCpuinfo();
+                proc_read = true;
+            }
+            if (auto it = proc_ids.find(cpu); it != proc_ids.end()) {
+                info.package = it->second.first;
+                info.core = it->second.second;
+            }
+        }
+        if (auto it = node_of.find(cpu); it != node_of.end()) {
+            info.node = it->second;
+        }
+        cpus.push_back(info);
+    }
+    return CpuTopology(move(cpus));
+}
+
+size_t CpuTopology::getCoreCount() const {
+    set<tuple<int, int, int>> cores;
+    for (const auto& info : cpus) {
+        cores.insert({info.node, info.package, info.core});
+    }
+    return cores.size();
+}
+
+size_t CpuTopology::getPackageCount() const {
+    set<int> packages;
+    for (const auto& info : cpus) {
+        packages.insert(info.package);
+    }
+    return packages.size();
+}
+
+size_t CpuTopology::getNodeCount() const {
+    set<int> nodes;
+    for (const auto& info : cpus) {
+        nodes.insert(info.node);
+    }
+    return nodes.size();
+}
+
+string CpuTopology::describe() const {
+    auto plural = [](size_t count, const string& noun) {
+        return to_string(count) + " " + noun + (count == 1 ? "" : "s");
+    };
+    return plural(cpus.size(), "CPU") + " (" + plural(getCoreCount(), "core") + "), " +
+        plural(getPackageCount(), "package") + ", " + plural(getNodeCount(), "NUMA node");
+}
+
+// ThreadPlacer implementation
+void ThreadPlacer::configure(PlacementPolicy new_policy, CpuTopology new_topology, int chef_count,
+                             int intake_count) {
+    policy = new_policy;
+    topology = move(new_topology);
+    chefs = chef_count;
+    intake_workers = intake_count;
+    compact_order.clear();
+    spread_order.clear();
+    kitchen_cpus.clear();
+    service_cpus.clear();
+    pinned = 0;
+    failed = 0;
+
+    // Rank every CPU within its core and every core within its package;
+    // the topology is already sorted, so siblings are adjacent
+    struct Slot {
+        int sibling;
+        int core_rank;
+        int package_rank;
+        int cpu;
+    };
+    vector<Slot> slots;
+    vector<vector<int>> cores;
+    int package_rank = -1;
+    int core_rank = 0;
+    int sibling = 0;
+    const CpuInfo* previous = nullptr;
+    for (const auto& info : topology.getCpus()) {
+        bool new_package = !previous || info.node != previous->node || info.package != previous->package;
+        bool new_core = new_package || info.core != previous->core;
+        if (new_package) {
+            ++package_rank;
+            core_rank = 0;
+        } else if (new_core) {
+            ++core_rank;
+        }
+        sibling = new_core ? 0 : sibling + 1;
+        if (new_core) {
+            cores.emplace_back();
+        }
+        cores.back().push_back(info.cpu);
+        slots.push_back({sibling, core_rank, package_rank, info.cpu});
+        compact_order.push_back(info.cpu);
+        previous = &info;
+    }
+    sort(slots.begin(), slots.end(), [](const Slot& a, const Slot& b) {
+        return tie(a.sibling, a.core_rank, a.package_rank) < tie(b.sibling, b.core_rank, b.package_rank);
+    });
+    for (const auto& slot : slots) {
+        spread_order.push_back(slot.cpu);
+    }
+
+    // Isolate: the last core serves everyone but the chefs. A single core
+    // gives up its last sibling instead; a single CPU cannot be split.
+    if (cores.size() > 1) {
+        service_cpus = cores.back();
+        kitchen_cpus.assign(compact_order.begin(), compact_order.end() - service_cpus.size());
+    } else if (compact_order.size() > 1) {
+        service_cpus = {compact_order.back()};
+        kitchen_cpus.assign(compact_order.begin(), compact_order.end() - 1);
+    } else {
+        service_cpus = kitchen_cpus = compact_order;
+    }
+}
+
+vector<int> ThreadPlacer::cpusFor(WorkerRole role, int index) const {
+    if (policy == PlacementPolicy::NONE || topology.getCpuCount() <= 1) {
+        return {};
+    }
+    if (policy == PlacementPolicy::ISOLATE) {
+        if (role == WorkerRole::CHEF) {
+            return {kitchen_cpus[index % kitchen_cpus.size()]};
+        }
+        return service_cpus;
+    }
+
+    // Compact and spread hand out CPUs in the same worker order: chefs, the
+    // driver, intake, then services, wrapping around when workers outnumber CPUs
+    int sequence = 0;
+    switch (role) {
+        case WorkerRole::CHEF:
+            sequence = index;
+            break;
+        case WorkerRole::DRIVER:
+            sequence = chefs;
+            break;
+        case WorkerRole::INTAKE:
+            sequence = chefs + 1 + (index < 0 ? intake_workers : index);
+            break;
+        case WorkerRole::SERVICE:
+            sequence = chefs + 1 + intake_workers + 1 + index;
+            break;
+    }
+    const vector<int>& order = policy == PlacementPolicy::COMPACT ? compact_order : spread_order;
+    return {order[sequence % order.size()]};
+}
+
+bool ThreadPlacer::pinCurrentThread(WorkerRole role, int index) {
+    vector<int> cpus = cpusFor(role, index);
+    if (cpus.empty()) {
+        return false;
+    }
+    bool ok = false;
+#if defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int cpu : cpus) {
+        CPU_SET(cpu, &set);
+    }
+    ok = pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#elif defined(_WIN32)
+    DWORD_PTR mask = 0;
+    for (int cpu : cpus) {
+        if (cpu < static_cast<int>(sizeof(DWORD_PTR) * 8)) {
+            mask |= DWORD_PTR{1} << cpu;
+        }
+    }
+    ok = mask != 0 && SetThreadAffinityMask(GetCurrentThread(), mask) != 0;
+#endif
+    (ok ? pinned : failed)++;
+    return ok;
+}
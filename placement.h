@@ -0,0 +1,104 @@
+#pragma once
+#include <bits/stdc++.h>
+
+using namespace std;
+
+// Topology-aware placement of the shop's worker threads.
+//
+// CpuTopology reads the CPUs this process may run on and how they group into
+// cores, packages and NUMA nodes (sysfs, falling back to /proc/cpuinfo). A
+// ThreadPlacer maps each worker to CPUs under a policy:
+//
+//  * compact: consecutive workers on hyperthread siblings, then neighbouring
+//    cores of the same package, so the shared queues and counters stay in
+//    one cache hierarchy
+//  * spread: one worker per physical core, alternating packages, before any
+//    core gets a second worker
+//  * isolate: the last core is reserved for the driver, intake and service
+//    threads; chefs are packed compactly on the rest and share their CPUs
+//    with nothing else
+//
+// Workers pin themselves before touching anything else, so the stack, random
+// stream and thread-local buffers (tracer, allocation tracker) they create
+// afterwards are first-touched on their own node. Without a policy, off
+// Linux/Windows or on a single CPU nothing is pinned.
+
+enum class PlacementPolicy { NONE, COMPACT, SPREAD, ISOLATE };
+
+constexpr string_view PLACEMENT_POLICY_NAMES[] = {"none", "compact", "spread", "isolate"};
+
+constexpr string_view placementPolicyToString(PlacementPolicy policy) {
+    return PLACEMENT_POLICY_NAMES[static_cast<int>(policy)];
+}
+
+// False for an unknown name
+bool parsePlacementPolicy(string_view name, PlacementPolicy& policy);
+
+enum class WorkerRole {
+    CHEF,      // index = chef number - 1
+    DRIVER,
+    INTAKE,    // customers (index = customer number - 1); the order server passes -1
+    SERVICE    // 0 restocker, 1 statistics, 2 checkpoints, 3 metrics publisher
+};
+
+struct CpuInfo {
+    int cpu = 0;
+    int core = 0;      // physical core id within the package
+    int package = 0;
+    int node = 0;
+};
+
+class CpuTopology {
+private:
+    vector<CpuInfo> cpus;   // sorted by node, package, core, cpu
+
+public:
+    CpuTopology() = default;
+    explicit CpuTopology(vector<CpuInfo> cpu_list);
+
+    // The CPUs in this process's affinity mask. Falls back to one core per
+    // CPU when the topology files are unavailable.
+    static CpuTopology detect();
+
+    const vector<CpuInfo>& getCpus() const { return cpus; }
+    size_t getCpuCount() const { return cpus.size(); }
+    size_t getCoreCount() const;
+    size_t getPackageCount() const;
+    size_t getNodeCount() const;
+    // e.g. "8 CPUs (4 cores), 1 package, 1 NUMA node"
+    string describe() const;
+};
+
+class ThreadPlacer {
+private:
+    PlacementPolicy policy = PlacementPolicy::NONE;
+    CpuTopology topology;
+    int chefs = 0;
+    int intake_workers = 0;
+    vector<int> compact_order;   // CPUs, siblings adjacent
+    vector<int> spread_order;    // CPUs, first sibling of every core first
+    vector<int> kitchen_cpus;    // isolate: chefs only
+    vector<int> service_cpus;    // isolate: everything else
+    atomic<int> pinned{0};
+    atomic<int> failed{0};
+
+public:
+    // Plans placement for `chefs` chefs and `intake_workers` intake threads.
+    // Call before starting the workers; not safe while they are pinning.
+    void configure(PlacementPolicy new_policy, CpuTopology new_topology, int chef_count, int intake_count);
+
+    PlacementPolicy getPolicy() const { return policy; }
+    const CpuTopology& getTopology() const { return topology; }
+
+    // CPUs a worker may run on; empty when it is left to the scheduler
+    vector<int> cpusFor(WorkerRole role, int index) const;
+
+    // Pins the calling thread to cpusFor(role, index). Returns false if it
+    // was left unpinned (no policy, or the OS refused).
+    bool pinCurrentThread(WorkerRole role, int index);
+
+    int getPinnedThreads() const { return pinned.load(); }
+    int getFailedPins() const { return failed.load(); }
+};
+
+extern ThreadPlacer g_placement;
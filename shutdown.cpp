@@ -0,0 +1,39 @@
+#include <bits/stdc++.h>
+#include "shutdown.h"
+#include "tracer.h"
+using namespace std;
+
+// Trace span names, indexed by ShutdownPhase
+static constexpr const char* SHUTDOWN_PHASE_TRACE_NAMES[] = {
+    "open", "drain kitchen", "drain delivery", "settle refunds", "close", "closed"
+};
+
+// ShutdownCoordinator implementation
+ShutdownCoordinator::ShutdownCoordinator() : phase_start(g_sim_clock.now()) {}
+
+void ShutdownCoordinator::advance(ShutdownPhase next) {
+    {
+        lock_guard<mutex> lock(phase_mutex);
+        ShutdownPhase current = phase.load();
+        if (next <= current) {
+            return;
+        }
+        auto now = g_sim_clock.now();
+        phase_durations[static_cast<int>(current)] = now - phase_start;
+        g_tracer.recordSpan(SHUTDOWN_PHASE_TRACE_NAMES[static_cast<int>(current)],
+            g_tracer.toNs(phase_start), g_tracer.toNs(now));
+        phase_start = now;
+        phase.store(next);
+    }
+    changed.notify_all();
+}
+
+void ShutdownCoordinator::signal() {
+    // Taking the lock orders this notify after any waiter's predicate check
+    { lock_guard<mutex> lock(phase_mutex); }
+    changed.notify_all();
+}
+
+chrono::nanoseconds ShutdownCoordinator::getPhaseDuration(ShutdownPhase finished) const {
+    return phase_durations[static_cast<int>(finished)];
+}
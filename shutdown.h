@@ -0,0 +1,68 @@
+#pragma once
+#include <bits/stdc++.h>
+#include "simulation.h"
+
+using namespace std;
+
+// Closing sequence of the pizzeria. Each phase ends as soon as its work is
+// done (signalled by order completions, deliveries and customers leaving)
+// rather than after a fixed sleep, and every background loop waits on the
+// coordinator so closing wakes it immediately.
+enum class ShutdownPhase {
+    OPEN,              // taking orders
+    INTAKE_STOPPED,    // no new orders; kitchen finishing queued ones
+    KITCHEN_DRAINED,   // every placed order cooked; deliveries in flight
+    DELIVERY_DRAINED,  // every cooked order delivered (or the time limit hit)
+    SETTLED,           // refunds issued for anything left over
+    CLOSED             // worker threads exit
+};
+
+constexpr int SHUTDOWN_PHASE_COUNT = static_cast<int>(ShutdownPhase::CLOSED) + 1;
+
+constexpr string_view SHUTDOWN_PHASE_NAMES[] = {
+    "open", "intake stopped", "kitchen drained", "delivery drained", "settled", "closed"
+};
+
+constexpr string_view shutdownPhaseToString(ShutdownPhase phase) {
+    return SHUTDOWN_PHASE_NAMES[static_cast<int>(phase)];
+}
+
+class ShutdownCoordinator {
+private:
+    mutex phase_mutex;
+    condition_variable changed;
+    atomic<ShutdownPhase> phase{ShutdownPhase::OPEN};
+    SimClock::time_point phase_start;
+    array<chrono::nanoseconds, SHUTDOWN_PHASE_COUNT> phase_durations{};
+
+public:
+    ShutdownCoordinator();
+
+    ShutdownPhase getPhase() const { return phase.load(); }
+    bool reached(ShutdownPhase target) const { return phase.load() >= target; }
+
+    // Ends the current phase and enters `next` (phases only move forward);
+    // wakes every waiter
+    void advance(ShutdownPhase next);
+
+    // Call whenever work that a waitUntil predicate depends on completes
+    void signal();
+
+    // Waits until pred() holds, re-checking on every signal() and advance(),
+    // or until `timeout` passes. Returns pred(). pred runs under the
+    // coordinator's lock, so it should only read atomics.
+    template <class Predicate>
+    bool waitUntil(Predicate pred, chrono::nanoseconds timeout) {
+        unique_lock<mutex> lock(phase_mutex);
+        return g_sim_clock.waitFor(lock, changed, timeout, pred);
+    }
+
+    // Interruptible sleep for periodic work: true as soon as `target` is
+    // reached, false once `duration` passes without it
+    bool sleepUnless(ShutdownPhase target, chrono::nanoseconds duration) {
+        return waitUntil([&] { return reached(target); }, duration);
+    }
+
+    // Time spent in a phase that has ended
+    chrono::nanoseconds getPhaseDuration(ShutdownPhase finished) const;
+};
@@ -0,0 +1,91 @@
+#include <bits/stdc++.h>
+#include "simulation.h"
+using namespace std;
+
+// Global clock
+SimClock g_sim_clock;
+
+atomic<uint64_t> SimRandom::master_seed{0};
+
+// Actor whose token the current thread holds or waits for
+static thread_local int current_actor = SimClock::NO_ACTOR;
+
+// SimClock implementation
+void SimClock::setVirtual(bool enabled) {
+    lock_guard<mutex> lock(scheduler_mutex);
+    virtual_time = enabled;
+    epoch = chrono::steady_clock::now();
+    virtual_now = chrono::nanoseconds::zero();
+}
+
+void SimClock::passToken() {
+    if (sleepers.empty()) {
+        running = NO_ACTOR;
+        return;
+    }
+    auto [wake, sequence, actor] = *sleepers.begin();
+    sleepers.erase(sleepers.begin());
+    virtual_now = max(virtual_now, chrono::nanoseconds(wake));
+    running = actor;
+    token_passed.notify_all();
+}
+
+void SimClock::waitForToken(unique_lock<mutex>& lock, int actor) {
+    token_passed.wait(lock, [&] { return running == actor; });
+}
+
+void SimClock::sleepFor(chrono::nanoseconds duration) {
+    if (!virtual_time || current_actor == NO_ACTOR) {
+        this_thread::sleep_for(duration);
+        return;
+    }
+    unique_lock<mutex> lock(scheduler_mutex);
+    sleepers.emplace((virtual_now + duration).count(), next_sequence++, current_actor);
+    passToken();
+    waitForToken(lock, current_actor);
+}
+
+int SimClock::addActor() {
+    if (!virtual_time) {
+        return NO_ACTOR;
+    }
+    lock_guard<mutex> lock(scheduler_mutex);
+    int actor = next_actor++;
+    sleepers.emplace(virtual_now.count(), next_sequence++, actor);
+    return actor;
+}
+
+void SimClock::beginActor(int actor) {
+    current_actor = actor;
+    if (actor == NO_ACTOR) {
+        return;
+    }
+    unique_lock<mutex> lock(scheduler_mutex);
+    if (running == NO_ACTOR) {
+        passToken();
+    }
+    waitForToken(lock, actor);
+}
+
+void SimClock::endActor() {
+    if (current_actor == NO_ACTOR) {
+        return;
+    }
+    lock_guard<mutex> lock(scheduler_mutex);
+    if (running == current_actor) {
+        passToken();
+    }
+    current_actor = NO_ACTOR;
+}
+
+// SimActorScope implementation
+SimActorScope::SimActorScope(int actor_id) : actor(actor_id) {
+    g_sim_clock.beginActor(actor);
+}
+
+void SimActorScope::leave() {
+    if (actor != SimClock::NO_ACTOR) {
+        g_sim_clock.endActor();
+        actor = SimClock::NO_ACTOR;
+    }
+}
@@ -0,0 +1,205 @@
+#pragma once
+#include <bits/stdc++.h>
+
+using namespace std;
+
+// Reproducible simulation runs: one master seed and an optional virtual clock.
+//
+// Every actor (chef, customer, delivery, restocker) draws from its own
+// counter-based random stream: value n of stream s is a pure function of
+// (master seed, s, n), so streams need no locking and the workload each actor
+// generates does not depend on thread interleaving. With the same seed the
+// customers place the same orders at the same intervals and every cook,
+// delivery and restock takes the same time, in real time or virtual time.
+//
+// Under virtual time the actors run one at a time in a deterministic order
+// and sleeps advance a simulated clock instead of blocking, so a rerun
+// produces identical order sequences and results (and runs as fast as the
+// CPU allows). Orders arriving through the socket order server are not part
+// of the deterministic schedule.
+
+enum class SimStreamKind : uint32_t {
+    PIZZERIA,
+    CHEF,
+    CUSTOMER,
+    DELIVERY
+};
+
+constexpr uint64_t simStream(SimStreamKind kind, uint32_t index = 0) {
+    return (static_cast<uint64_t>(kind) << 32) | index;
+}
+
+// Inclusive range of a uniform integer draw
+struct UniformRange {
+    int low;
+    int high;
+
+    constexpr double mean() const { return (static_cast<double>(low) + high) / 2; }
+    // Variance of the discrete uniform distribution
+    constexpr double variance() const {
+        double width = static_cast<double>(high) - low + 1;
+        return (width * width - 1) / 12;
+    }
+};
+
+class SimRandom {
+private:
+    static atomic<uint64_t> master_seed;
+
+    uint64_t key;
+    uint64_t counter;
+
+public:
+    static void setMasterSeed(uint64_t seed) { master_seed.store(seed); }
+    static uint64_t getMasterSeed() { return master_seed.load(); }
+
+    // SplitMix64 finalizer; a bijective 64-bit mix
+    static constexpr uint64_t mix(uint64_t x) {
+        x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+        return x ^ (x >> 31);
+    }
+
+    // The stream key is fixed at construction, so set the master seed first
+    explicit SimRandom(uint64_t stream)
+        : key(mix(getMasterSeed() ^ mix(stream + 0x9E3779B97F4A7C15ULL))), counter(0) {}
+
+    uint64_t next() {
+        return mix(key + ++counter * 0x9E3779B97F4A7C15ULL);
+    }
+
+    // Uniform integer in [low, high]; unbiased (Lemire's multiply-shift with
+    // rejection), and identical on every standard library unlike
+    // uniform_int_distribution
+    int uniformInt(int low, int high) {
+        uint64_t range = static_cast<uint64_t>(static_cast<int64_t>(high) - low) + 1;
+        uint64_t threshold = (0 - range) % range;
+        while (true) {
+            uint64_t x = next() >> 32;
+            uint64_t product = x * range;
+            if ((product & 0xFFFFFFFFULL) >= threshold) {
+                return low + static_cast<int>(product >> 32);
+            }
+        }
+    }
+
+    int uniformInt(UniformRange range) { return uniformInt(range.low, range.high); }
+};
+
+// Time source for the simulation. In real mode it is steady_clock and
+// this_thread::sleep_for. In virtual mode actors hold a single run token:
+// sleeping hands the token to the actor with the earliest wake-up time (ties
+// go to whoever slept first) and moves the clock forward to it.
+class SimClock {
+public:
+    using time_point = chrono::steady_clock::time_point;
+    static constexpr int NO_ACTOR = -1;
+
+private:
+    // Poll step for condition waits under virtual time
+    static constexpr chrono::milliseconds VIRTUAL_POLL{10};
+
+    bool virtual_time = false;
+    time_point epoch;
+
+    mutex scheduler_mutex;
+    condition_variable token_passed;
+    chrono::nanoseconds virtual_now{0};
+    uint64_t next_sequence = 0;
+    int next_actor = 0;
+    int running = NO_ACTOR;
+    // (wake time, sleep order, actor) for actors waiting for the token
+    set<tuple<int64_t, uint64_t, int>> sleepers;
+
+    void passToken(); // caller holds scheduler_mutex
+    void waitForToken(unique_lock<mutex>& lock, int actor);
+
+public:
+    SimClock() : epoch(chrono::steady_clock::now()) {}
+
+    // Call before any actor thread starts
+    void setVirtual(bool enabled);
+    bool isVirtual() const { return virtual_time; }
+
+    time_point now() {
+        if (!virtual_time) {
+            return chrono::steady_clock::now();
+        }
+        lock_guard<mutex> lock(scheduler_mutex);
+        return epoch + virtual_now;
+    }
+
+    // Simulated time since the clock was configured
+    chrono::nanoseconds elapsed() { return now() - epoch; }
+
+    void sleepFor(chrono::nanoseconds duration);
+
+    // Condition-variable wait that is also correct under virtual time, where
+    // blocking on the cv would keep the run token; there the wait polls the
+    // predicate every VIRTUAL_POLL of simulated time. Works with any lock and
+    // condition variable pair (see lock_profiler.h). Returns pred().
+    template <class Lock, class CondVar, class Predicate>
+    bool waitFor(Lock& lock, CondVar& cv, chrono::nanoseconds timeout, Predicate pred) {
+        if (!virtual_time) {
+            return cv.wait_for(lock, timeout, pred);
+        }
+        while (!pred() && timeout > chrono::nanoseconds::zero()) {
+            chrono::nanoseconds step = min<chrono::nanoseconds>(timeout, VIRTUAL_POLL);
+            lock.unlock();
+            sleepFor(step);
+            lock.lock();
+            timeout -= step;
+        }
+        return pred();
+    }
+
+    // Timed wait with no predicate; under virtual time a notify cannot cut it
+    // short, so it always lasts `timeout` of simulated time
+    template <class Lock, class CondVar>
+    void waitFor(Lock& lock, CondVar& cv, chrono::nanoseconds timeout) {
+        if (!virtual_time) {
+            cv.wait_for(lock, timeout);
+            return;
+        }
+        lock.unlock();
+        sleepFor(timeout);
+        lock.lock();
+    }
+
+    template <class Lock, class CondVar, class Predicate>
+    void wait(Lock& lock, CondVar& cv, Predicate pred) {
+        if (!virtual_time) {
+            cv.wait(lock, pred);
+            return;
+        }
+        while (!pred()) {
+            lock.unlock();
+            sleepFor(VIRTUAL_POLL);
+            lock.lock();
+        }
+    }
+
+    // Virtual time only: registers an actor that becomes runnable now. Call it
+    // from the thread that holds the token (or before the run starts) so
+    // actors are numbered and scheduled in a deterministic order. Returns
+    // NO_ACTOR in real time.
+    int addActor();
+
+    // Called on the actor's own thread: waits for the token / gives it up
+    void beginActor(int actor);
+    void endActor();
+};
+
+// Runs the current thread as a scheduled actor for the scope's lifetime
+class SimActorScope {
+private:
+    int actor;
+
+public:
+    explicit SimActorScope(int actor_id);
+    ~SimActorScope() { leave(); }
+    void leave(); // give up the token early, e.g. before joining other actors
+};
+
+// Global clock shared by all simulation threads
+extern SimClock g_sim_clock;
@@ -0,0 +1,205 @@
+#include <bits/stdc++.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <sys/mman.h>
+#endif
+#include "snapshot.h"
+using namespace std;
+
+#ifdef _WIN32
+// No mmap or fsync: the snapshot is read into memory instead, and rename
+// does not replace an existing file
+static int fsync(int fd) { return _commit(fd); }
+static int replaceFile(const char* from, const char* to) {
+    remove(to);
+    return rename(from, to);
+}
+#else
+static int replaceFile(const char* from, const char* to) { return rename(from, to); }
+#endif
+
+// Stock is padded so the order records start 8-byte aligned
+static size_t ordersOffset(size_t ingredient_count) {
+    size_t stock_end = sizeof(SnapshotHeader) + ingredient_count * sizeof(int32_t);
+    return (stock_end + 7) / 8 * 8;
+}
+
+// FNV-1a over 64-bit words; every section is a multiple of 8 bytes
+static uint64_t checksumWords(uint64_t hash, const void* data, size_t bytes) {
+    const unsigned char* p = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < bytes; i += 8) {
+        uint64_t word;
+        memcpy(&word, p + i, 8);
+        hash = (hash ^ word) * 0x100000001B3ULL;
+    }
+    return hash;
+}
+
+static constexpr uint64_t CHECKSUM_SEED = 0xCBF29CE484222325ULL;
+
+uint64_t catalogFingerprint(const MenuCatalog& catalog) {
+    uint64_t hash = CHECKSUM_SEED;
+    auto mix = [&hash](const void* data, size_t bytes) {
+        const unsigned char* p = static_cast<const unsigned char*>(data);
+        for (size_t i = 0; i < bytes; ++i) {
+            hash = (hash ^ p[i]) * 0x100000001B3ULL;
+        }
+    };
+    for (size_t i = 0; i < catalog.getIngredientCount(); ++i) {
+        string_view name = catalog.getIngredientName(static_cast<IngredientId>(i));
+        mix(name.data(), name.size());
+        mix("|", 1);
+    }
+    for (size_t i = 0; i < catalog.getItemCount(); ++i) {
+        auto item = static_cast<MenuItemId>(i);
+        string_view name = catalog.getItemName(item);
+        double price = catalog.getItemPrice(item);
+        mix(name.data(), name.size());
+        mix(&price, sizeof(price));
+        mix(catalog.getRecipeIngredients(item), catalog.getRecipeSize(item) * sizeof(IngredientId));
+        mix(catalog.getRecipeQuantities(item), catalog.getRecipeSize(item) * sizeof(uint16_t));
+    }
+    return hash;
+}
+
+size_t writeSnapshotFile(const string& path, SnapshotHeader header, const vector<int32_t>& stock,
+                         const vector<SnapshotOrder>& orders) {
+    size_t stock_bytes = stock.size() * sizeof(int32_t);
+    size_t padding = ordersOffset(stock.size()) - sizeof(SnapshotHeader) - stock_bytes;
+    const uint64_t zeros = 0;
+
+    header.magic = SNAPSHOT_MAGIC;
+    header.version = SNAPSHOT_VERSION;
+    header.header_size = sizeof(SnapshotHeader);
+    header.ingredient_count = static_cast<uint32_t>(stock.size());
+    header.order_count = static_cast<uint32_t>(orders.size());
+
+    // Checksum the stock and its padding as one run of words
+    vector<int32_t> padded_stock(stock);
+    padded_stock.resize((stock_bytes + padding) / sizeof(int32_t), 0);
+    uint64_t checksum = checksumWords(CHECKSUM_SEED, padded_stock.data(), stock_bytes + padding);
+    header.payload_checksum = checksumWords(checksum, orders.data(), orders.size() * sizeof(SnapshotOrder));
+
+    string temp_path = path + ".tmp";
+#ifdef _WIN32
+    int fd = open(temp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_BINARY, 0644);
+#else
+    int fd = open(temp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+#endif
+    if (fd < 0) {
+        throw runtime_error("snapshot: cannot create " + temp_path + ": " + strerror(errno));
+    }
+    auto writeAll = [&](const void* data, size_t bytes) {
+        const char* p = static_cast<const char*>(data);
+        while (bytes > 0) {
+            ssize_t written = write(fd, p, bytes);
+            if (written < 0 && errno == EINTR) {
+                continue;
+            }
+            if (written <= 0) {
+                string error = strerror(errno);
+                close(fd);
+                unlink(temp_path.c_str());
+                throw runtime_error("snapshot: write to " + temp_path + " failed: " + error);
+            }
+            p += written;
+            bytes -= static_cast<size_t>(written);
+        }
+    };
+    writeAll(&header, sizeof(header));
+    writeAll(stock.data(), stock_bytes);
+    writeAll(&zeros, padding);
+    writeAll(orders.data(), orders.size() * sizeof(SnapshotOrder));
+
+    // Durable before it replaces the previous snapshot
+    if (fsync(fd) != 0 || close(fd) != 0 || replaceFile(temp_path.c_str(), path.c_str()) != 0) {
+        string error = strerror(errno);
+        unlink(temp_path.c_str());
+        throw runtime_error("snapshot: cannot replace " + path + ": " + error);
+    }
+    return ordersOffset(stock.size()) + orders.size() * sizeof(SnapshotOrder);
+}
+
+// MappedSnapshot implementation
+MappedSnapshot::MappedSnapshot(const string& path) {
+#ifdef _WIN32
+    int fd = open(path.c_str(), O_RDONLY | O_BINARY);
+#else
+    int fd = open(path.c_str(), O_RDONLY);
+#endif
+    if (fd < 0) {
+        throw runtime_error("snapshot: cannot open " + path + ": " + strerror(errno));
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < sizeof(SnapshotHeader)) {
+        close(fd);
+        throw runtime_error("snapshot: " + path + " is too small to be a snapshot");
+    }
+    mapped_size = static_cast<size_t>(info.st_size);
+#ifdef _WIN32
+    mapping = malloc(mapped_size);
+    size_t loaded = 0;
+    while (mapping && loaded < mapped_size) {
+        int count = read(fd, static_cast<char*>(mapping) + loaded, static_cast<unsigned>(mapped_size - loaded));
+        if (count <= 0) {
+            free(mapping);
+            mapping = nullptr;
+        } else {
+            loaded += static_cast<size_t>(count);
+        }
+    }
+    close(fd);
+    if (!mapping) {
+        throw runtime_error("snapshot: cannot read " + path);
+    }
+#else
+    mapping = mmap(nullptr, mapped_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd); // the mapping keeps the file referenced
+    if (mapping == MAP_FAILED) {
+        mapping = nullptr;
+        throw runtime_error("snapshot: cannot map " + path + ": " + strerror(errno));
+    }
+#endif
+
+    auto reject = [&](const string& reason) {
+        unmap();
+        throw runtime_error("snapshot: " + path + ": " + reason);
+    };
+    const char* base = static_cast<const char*>(mapping);
+    header = reinterpret_cast<const SnapshotHeader*>(base);
+    if (header->magic != SNAPSHOT_MAGIC) {
+        reject("not a pizzeria snapshot");
+    }
+    if (header->version != SNAPSHOT_VERSION || header->header_size != sizeof(SnapshotHeader)) {
+        reject("unsupported snapshot version " + to_string(header->version));
+    }
+    size_t orders_offset = ordersOffset(header->ingredient_count);
+    if (mapped_size != orders_offset + static_cast<size_t>(header->order_count) * sizeof(SnapshotOrder)) {
+        reject("truncated or oversized file");
+    }
+    if (checksumWords(CHECKSUM_SEED, base + sizeof(SnapshotHeader), mapped_size - sizeof(SnapshotHeader)) !=
+        header->payload_checksum) {
+        reject("checksum mismatch");
+    }
+    stock = reinterpret_cast<const int32_t*>(base + sizeof(SnapshotHeader));
+    orders = reinterpret_cast<const SnapshotOrder*>(base + orders_offset);
+}
+
+MappedSnapshot::~MappedSnapshot() {
+    unmap();
+}
+
+void MappedSnapshot::unmap() {
+    if (mapping) {
+#ifdef _WIN32
+        free(mapping);
+#else
+        munmap(mapping, mapped_size);
+#endif
+        mapping = nullptr;
+    }
+}
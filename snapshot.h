@@ -0,0 +1,111 @@
+#pragma once
+#include <bits/stdc++.h>
+#include "catalog.h"
+
+using namespace std;
+
+// Binary checkpoint of the shop's state for warm restarts.
+//
+// A snapshot file is a fixed header followed by the ingredient stock (one
+// int32 per ingredient) and one fixed-size record per unfinished order, in
+// the order they should be re-queued. Everything is plain data at fixed
+// offsets, so a restart maps the file and reads the records in place. Files
+// are written to a temporary name and renamed, so a crash mid-write leaves the
+// previous snapshot intact; the header carries a version, a fingerprint of the
+// menu it was taken with and a checksum of the payload.
+
+// Bump SNAPSHOT_VERSION whenever SnapshotHeader or SnapshotOrder changes.
+constexpr uint32_t SNAPSHOT_MAGIC = 0x4E535A50; // "PZSN"
+constexpr uint32_t SNAPSHOT_VERSION = 5;
+
+// Stage time that was never reached
+constexpr uint32_t SNAPSHOT_NO_TIME = UINT32_MAX;
+
+// Where a restored order goes
+enum class SnapshotOrderLocation : uint8_t {
+    ORDER_QUEUE,   // queued, or in the kitchen when the snapshot was taken
+    READY_QUEUE    // ready, or out for delivery but not yet settled
+};
+
+struct SnapshotHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t header_size;
+    uint32_t ingredient_count;
+    uint32_t item_count;
+    uint32_t order_count;
+    uint64_t catalog_fingerprint;
+    uint64_t payload_checksum;     // FNV-1a over everything after the header
+    int64_t taken_at_unix_ms;
+
+    // Counters and ledger, consistent with the order records
+    int32_t next_order_id;
+    int32_t orders_placed;
+    int32_t orders_completed;
+    int32_t orders_delivered;
+    int32_t orders_cancelled;
+    int32_t kitchen_cancellations;  // of orders_cancelled, those never completed
+    double total_earnings;
+    double total_refunds;
+    double cancellation_refunds;
+    double cancellation_fees;
+};
+
+struct SnapshotOrder {
+    int32_t order_id;
+    int32_t customer_id;
+    double price;
+    uint32_t age_ms;               // placed -> snapshot
+    uint32_t ready_age_ms;         // ready -> snapshot, or SNAPSHOT_NO_TIME
+    MenuItemId items[MAX_ORDER_ITEMS];
+    uint8_t item_count;
+    SnapshotOrderLocation location;
+    uint8_t paid;
+};
+
+static_assert(is_trivially_copyable_v<SnapshotHeader> && is_trivially_copyable_v<SnapshotOrder>,
+              "snapshot records are written and mapped verbatim");
+
+// Result of writing or restoring a snapshot
+struct SnapshotStats {
+    size_t orders = 0;
+    size_t bytes = 0;
+    chrono::nanoseconds pause{0};    // writer: time the queues were locked
+    chrono::nanoseconds elapsed{0};  // whole write or restore
+};
+
+// Identifies a menu by its names, prices and recipes; a snapshot only
+// restores into the catalog it was taken with
+uint64_t catalogFingerprint(const MenuCatalog& catalog);
+
+// Writes header, stock and orders to `path` (via `path`.tmp and rename) and
+// fills in the header's sizes and checksum. Returns the file size. Throws
+// runtime_error on I/O failure.
+size_t writeSnapshotFile(const string& path, SnapshotHeader header, const vector<int32_t>& stock,
+                         const vector<SnapshotOrder>& orders);
+
+// Read-only mapping of a snapshot file (read into memory on Windows). Throws runtime_error if the file
+// cannot be mapped or fails validation.
+class MappedSnapshot {
+private:
+    void* mapping = nullptr;
+    size_t mapped_size = 0;
+    const SnapshotHeader* header = nullptr;
+    const int32_t* stock = nullptr;
+    const SnapshotOrder* orders = nullptr;
+
+    void unmap();
+
+public:
+    explicit MappedSnapshot(const string& path);
+    ~MappedSnapshot();
+
+    MappedSnapshot(const MappedSnapshot&) = delete;
+    MappedSnapshot& operator=(const MappedSnapshot&) = delete;
+
+    const SnapshotHeader& getHeader() const { return *header; }
+    const int32_t* getStock() const { return stock; }
+    const SnapshotOrder* getOrders() const { return orders; }
+    size_t getOrderCount() const { return header->order_count; }
+    size_t getSize() const { return mapped_size; }
+};
@@ -0,0 +1,78 @@
+#pragma once
+#include <bits/stdc++.h>
+
+using namespace std;
+
+// Fixed-capacity builder for status messages. Text, integers and prices are
+// written straight into an inline buffer with to_chars, so building a line
+// never touches the heap; anything past the capacity is cut off.
+//
+//   StatusLine line;
+//   line << "DELIVERY: Order #" << id << " ($" << Dollars{price} << ")";
+//   g_pizzeria->printOrderStatus(line.view());
+
+// Fixed-point number with `decimals` digits, as printf("%.*f") writes it
+struct Decimal {
+    double value;
+    int decimals = 6;
+};
+
+// A price the way the logs have always shown it: six decimals cut (not
+// rounded) to two
+struct Dollars {
+    double amount;
+};
+
+class StatusLine {
+public:
+    static constexpr size_t CAPACITY = 256;
+
+private:
+    char buffer[CAPACITY];
+    size_t length = 0;
+
+public:
+    string_view view() const { return string_view(buffer, length); }
+
+    StatusLine& operator<<(string_view text) {
+        size_t count = min(text.size(), CAPACITY - length);
+        memcpy(buffer + length, text.data(), count);
+        length += count;
+        return *this;
+    }
+
+    StatusLine& operator<<(char c) {
+        if (length < CAPACITY) {
+            buffer[length++] = c;
+        }
+        return *this;
+    }
+
+    template <class Integer>
+        requires(is_integral_v<Integer> && !is_same_v<Integer, char> && !is_same_v<Integer, bool>)
+    StatusLine& operator<<(Integer value) {
+        auto result = to_chars(buffer + length, buffer + CAPACITY, value);
+        if (result.ec == errc()) {
+            length = static_cast<size_t>(result.ptr - buffer);
+        }
+        return *this;
+    }
+
+    StatusLine& operator<<(Decimal number) {
+        auto result = to_chars(buffer + length, buffer + CAPACITY, number.value, chars_format::fixed, number.decimals);
+        if (result.ec == errc()) {
+            length = static_cast<size_t>(result.ptr - buffer);
+        }
+        return *this;
+    }
+
+    StatusLine& operator<<(Dollars price) {
+        char digits[64];
+        auto result = to_chars(digits, digits + sizeof(digits), price.amount, chars_format::fixed, 6);
+        if (result.ec != errc()) {
+            return *this;
+        }
+        string_view text(digits, static_cast<size_t>(result.ptr - digits));
+        return *this << text.substr(0, text.find('.') + 3);
+    }
+};
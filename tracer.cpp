@@ -0,0 +1,151 @@
+#include <bits/stdc++.h>
+#include "tracer.h"
+using namespace std;
+
+// Global tracer
+Tracer g_tracer;
+
+// Tracer implementation
+Tracer::Tracer(size_t max_events)
+    : epoch(chrono::steady_clock::now()), max_events_per_thread(max_events) {}
+
+void Tracer::enable() {
+    epoch = g_sim_clock.now();
+    enabled.store(true, memory_order_release);
+}
+
+Tracer::ThreadBuffer& Tracer::localBuffer() {
+    struct Registration {
+        Tracer* owner = nullptr;
+        ThreadBuffer* buffer = nullptr;
+    };
+    thread_local Registration local;
+    if (local.owner != this) {
+        lock_guard<mutex> lock(registry_mutex);
+        buffers.push_back(make_unique<ThreadBuffer>());
+        local.buffer = buffers.back().get();
+        local.buffer->tid = static_cast<uint32_t>(buffers.size());
+        local.buffer->thread_name = "Thread " + to_string(local.buffer->tid);
+        // Zero-filled, so its pages are faulted in here rather than while recording
+        local.buffer->chunks.push_back(make_unique<Chunk>());
+        local.owner = this;
+    }
+    return *local.buffer;
+}
+
+// Moves to the next chunk, allocating one only if no earlier run left it
+// behind. The chunk list is read by the exporter only after threads finish.
+void Tracer::nextChunk(ThreadBuffer& buffer) {
+    if (++buffer.current_chunk == buffer.chunks.size()) {
+        // Left uninitialized: every slot is written before it is committed
+        buffer.chunks.push_back(unique_ptr<Chunk>(new Chunk));
+    }
+    buffer.used_in_chunk = 0;
+}
+
+void Tracer::append(const TraceEvent& event) {
+    ThreadBuffer& buffer = localBuffer();
+    size_t committed = buffer.committed.load(memory_order_relaxed);
+    if (committed >= max_events_per_thread) {
+        dropped_events.fetch_add(1, memory_order_relaxed);
+        return;
+    }
+    if (buffer.used_in_chunk == CHUNK_EVENTS) {
+        nextChunk(buffer);
+    }
+    buffer.chunks[buffer.current_chunk]->events[buffer.used_in_chunk++] = event;
+    buffer.committed.store(committed + 1, memory_order_release);
+}
+
+void Tracer::setThreadName(const string& name) {
+    ThreadBuffer& buffer = localBuffer();
+    lock_guard<mutex> lock(registry_mutex);
+    buffer.thread_name = name;
+}
+
+size_t Tracer::getEventCount() {
+    lock_guard<mutex> lock(registry_mutex);
+    size_t total = 0;
+    for (const auto& buffer : buffers) {
+        total += buffer->committed.load(memory_order_acquire);
+    }
+    return total;
+}
+
+void Tracer::clear() {
+    lock_guard<mutex> lock(registry_mutex);
+    for (auto& buffer : buffers) {
+        buffer->current_chunk = 0;
+        buffer->used_in_chunk = 0;
+        buffer->committed.store(0, memory_order_release);
+    }
+    dropped_events.store(0);
+}
+
+static void writeJsonString(ostream& out, const string& text) {
+    out << '"';
+    for (char c : text) {
+        if (c == '"' || c == '\\') out << '\\' << c;
+        else if (static_cast<unsigned char>(c) < 0x20) out << ' ';
+        else out << c;
+    }
+    out << '"';
+}
+
+bool Tracer::writeChromeTrace(const string& path) {
+    ofstream out(path);
+    if (!out) {
+        return false;
+    }
+
+    lock_guard<mutex> lock(registry_mutex);
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    out << "{\"ph\":\"M\",\"pid\":1,\"name\":\"process_name\",\"args\":{\"name\":\"Pizzeria\"}}";
+
+    // Timestamps are microseconds with nanosecond fractions
+    auto micros = [](uint64_t ns) {
+        ostringstream text;
+        text << ns / 1000 << '.' << setw(3) << setfill('0') << ns % 1000;
+        return text.str();
+    };
+
+    for (const auto& buffer : buffers) {
+        out << ",\n{\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer->tid << ",\"name\":\"thread_name\",\"args\":{\"name\":";
+        writeJsonString(out, buffer->thread_name);
+        out << "}}";
+
+        size_t count = buffer->committed.load(memory_order_acquire);
+        for (size_t i = 0; i < count; ++i) {
+            const TraceEvent& event = buffer->chunks[i / CHUNK_EVENTS]->events[i % CHUNK_EVENTS];
+            if (event.kind != TraceEventKind::ORDER_STAGE) {
+                out << ",\n{\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->tid << ",\"cat\":\"kitchen\",\"name\":\""
+                    << event.name << "\",\"ts\":" << micros(event.start_ns)
+                    << ",\"dur\":" << micros(event.duration_ns);
+                if (event.order_id != 0) {
+                    out << ",\"args\":{\"order\":" << event.order_id << "}";
+                }
+                out << "}";
+            }
+            if (event.kind != TraceEventKind::THREAD_SPAN) {
+                out << ",\n{\"ph\":\"b\",\"pid\":1,\"tid\":" << buffer->tid << ",\"cat\":\"order\",\"name\":\""
+                    << event.name << "\",\"id\":" << event.order_id << ",\"ts\":" << micros(event.start_ns)
+                    << ",\"args\":{\"order\":" << event.order_id << "}}";
+                out << ",\n{\"ph\":\"e\",\"pid\":1,\"tid\":" << buffer->tid << ",\"cat\":\"order\",\"name\":\""
+                    << event.name << "\",\"id\":" << event.order_id << ",\"ts\":"
+                    << micros(event.start_ns + event.duration_ns) << "}";
+            }
+        }
+    }
+    out << "\n]}\n";
+    return static_cast<bool>(out);
+}
+
+// TraceScope implementation
+TraceScope::TraceScope(const char* span_name, uint32_t order)
+    : name(span_name), order_id(order), start_ns(g_tracer.isEnabled() ? g_tracer.nowNs() : 0) {}
+
+TraceScope::~TraceScope() {
+    if (g_tracer.isEnabled()) {
+        g_tracer.recordSpan(name, start_ns, g_tracer.nowNs(), order_id);
+    }
+}
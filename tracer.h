@@ -0,0 +1,123 @@
+#pragma once
+#include <bits/stdc++.h>
+#include "simulation.h"
+
+using namespace std;
+
+// Low-overhead span tracing with Chrome trace-event JSON export.
+//
+// Each thread appends fixed-size events to its own chunked buffer, so
+// recording takes no locks (a mutex is only taken the first time a thread
+// records). Order lifecycle stages are written as async spans keyed by order
+// id, giving one timeline row per order. A stage closed by the thread that did
+// the work (chef prep and cooking, driver delivery) is one event that is
+// exported twice: on the order's row and as a complete event on the thread's
+// row, so each transition costs a single clock read. When tracing is disabled
+// every record call is a single relaxed load and branch.
+//
+// Load the exported file in chrome://tracing or https://ui.perfetto.dev.
+
+enum class TraceEventKind : uint8_t {
+    THREAD_SPAN,  // "X" event on the recording thread
+    ORDER_STAGE,  // "b"/"e" async pair with id = order id
+    ORDER_WORK    // ORDER_STAGE plus an "X" event on the recording thread
+};
+
+struct TraceEvent {
+    uint64_t start_ns;      // since Tracer::enable()
+    uint64_t duration_ns;
+    const char* name;       // must point at a string literal
+    uint32_t order_id;      // 0 if the span is not tied to an order
+    TraceEventKind kind;
+};
+
+class Tracer {
+private:
+    static constexpr size_t CHUNK_EVENTS = 4096;
+
+    struct Chunk {
+        TraceEvent events[CHUNK_EVENTS];
+    };
+
+    // Written only by its owning thread; `committed` publishes events to the
+    // exporter. Chunks are kept across clear() and reused.
+    struct ThreadBuffer {
+        uint32_t tid;
+        string thread_name;
+        vector<unique_ptr<Chunk>> chunks;
+        size_t current_chunk = 0;
+        size_t used_in_chunk = 0;
+        atomic<size_t> committed{0};
+    };
+
+    atomic<bool> enabled{false};
+    chrono::steady_clock::time_point epoch;
+    size_t max_events_per_thread;
+    atomic<uint64_t> dropped_events{0};
+
+    mutex registry_mutex;
+    vector<unique_ptr<ThreadBuffer>> buffers;
+
+    ThreadBuffer& localBuffer();
+    void nextChunk(ThreadBuffer& buffer);
+    void append(const TraceEvent& event);
+
+public:
+    explicit Tracer(size_t max_events = 1 << 20);
+
+    void enable();
+    void disable() { enabled.store(false, memory_order_relaxed); }
+    bool isEnabled() const { return enabled.load(memory_order_relaxed); }
+
+    // Timestamps follow the simulation clock, so virtual-time runs trace in
+    // simulated time
+    uint64_t nowNs() const {
+        return toNs(g_sim_clock.now());
+    }
+    uint64_t toNs(chrono::steady_clock::time_point time) const {
+        return time <= epoch ? 0 : chrono::duration_cast<chrono::nanoseconds>(time - epoch).count();
+    }
+
+    // Label for the calling thread's row in the viewer. Call it when the
+    // thread starts: it also sets up and pre-faults the thread's first chunk
+    // so recording does not page-fault later.
+    void setThreadName(const string& name);
+
+    void recordSpan(const char* name, uint64_t start_ns, uint64_t end_ns, uint32_t order_id = 0) {
+        if (isEnabled()) {
+            append({start_ns, end_ns - start_ns, name, order_id, TraceEventKind::THREAD_SPAN});
+        }
+    }
+
+    void recordOrderStage(const char* stage, uint32_t order_id, chrono::steady_clock::time_point start,
+                          chrono::steady_clock::time_point end, bool on_thread_row = false) {
+        if (isEnabled()) {
+            uint64_t start_ns = toNs(start);
+            append({start_ns, toNs(end) - start_ns, stage, order_id,
+                    on_thread_row ? TraceEventKind::ORDER_WORK : TraceEventKind::ORDER_STAGE});
+        }
+    }
+
+    size_t getEventCount();
+    // Discards recorded events; call only while no thread is recording
+    void clear();
+    uint64_t getDroppedEvents() const { return dropped_events.load(); }
+
+    // Call once every recording thread has finished. Returns false on I/O error.
+    bool writeChromeTrace(const string& path);
+};
+
+// RAII span on the current thread's row
+class TraceScope {
+private:
+    const char* name;
+    uint32_t order_id;
+    uint64_t start_ns;
+
+public:
+    TraceScope(const char* span_name, uint32_t order = 0);
+    ~TraceScope();
+};
+
+// Global tracer shared by all simulation threads
+extern Tracer g_tracer;